@@ -10,15 +10,35 @@
 
 
 
+#include <eskit/Archive.h>
+#include <eskit/Arena.h>
 #include <eskit/ArrayOps.h>
+#include <eskit/BatchCMA.h>
 #include <eskit/CMA.h>
+#include <eskit/Checkpoint.h>
+#include <eskit/Clock.h>
+#include <eskit/Coordinator.h>
 #include <eskit/CSA.h>
 #include <eskit/Distribution.h>
+#include <eskit/DistributionBuilder.h>
+#include <eskit/Doorbell.h>
+#include <eskit/FitnessCache.h>
+#include <eskit/Islands.h>
 #include <eskit/Matrix.h>
 #include <eskit/MeanWeights.h>
+#include <eskit/Observer.h>
 #include <eskit/Optimizer.h>
+#include <eskit/OptimizerPool.h>
+#include <eskit/ProcessFarm.h>
+#include <eskit/Profile.h>
 #include <eskit/Randomizer.h>
+#include <eskit/Restart.h>
 #include <eskit/SepCMA.h>
+#include <eskit/Server.h>
+#include <eskit/SharedChannel.h>
+#include <eskit/Socket.h>
+#include <eskit/ThreadPool.h>
+#include <eskit/Trace.h>
 
 
 
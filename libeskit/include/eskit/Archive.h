@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_ARCHIVE_H
+#define ESKIT_ARCHIVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <eskit/Types.h>
+#include <eskit/Observer.h>
+
+
+
+/*
+   Implements an append-only archive of all the evaluated points, in a
+   memory mapped file. The file starts with a 64 bytes header, followed by
+   the records. A record is N + 2 doubles : the generation, the fitness,
+   then the point. The records can thus be read back as a single matrix of
+   doubles, with no copy. The file is in the byte order of the writer.
+ */
+
+#define ESKIT_ARCHIVE_MAGIC 0x414b5345 /* "ESKA" */
+
+#define ESKIT_ARCHIVE_VERSION 1
+
+#define ESKIT_ARCHIVE_HEADER_SIZE 64
+
+
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t N;
+	uint64_t nbRecords;
+} ekArchiveHeader;
+
+
+
+typedef struct {
+	int fd;
+	int writable;
+	int failed;                 /* Set once a generation could not be added */
+	void* data;
+	size_t size;
+	size_t N;
+	size_t capacity;            /* Records which fit in the mapped file */
+	ekArchiveHeader* header;
+	double* records;
+} ekArchive;
+
+
+
+#define ekArchive_N(self) (self)->N
+
+#define ekArchive_nbRecords(self) ((size_t)((self)->header->nbRecords))
+
+#define ekArchive_records(self) (self)->records
+
+#define ekArchive_generation(self, i) ((size_t)((self)->records[(i) * ((self)->N + 2)]))
+
+#define ekArchive_fitness(self, i) (self)->records[(i) * ((self)->N + 2) + 1]
+
+#define ekArchive_x(self, i) ((const double*)((self)->records + (i) * ((self)->N + 2) + 2))
+
+#define ekArchive_failed(self) (self)->failed
+
+
+
+/*
+   Creates an archive file for points of dimension N, with room for capacity
+   records before the file grows. Returns 0 on failure.
+ */
+extern int
+ekArchive_create(ekArchive* self, const char* path, size_t N, size_t capacity);
+
+
+
+/* Maps an existing archive file, read-only. Returns 0 on failure. */
+extern int
+ekArchive_open(ekArchive* self, const char* path);
+
+
+
+/* Unmaps the archive, trimming the unused room of an archive being written */
+extern void
+ekArchive_close(ekArchive* self);
+
+
+
+/*
+   Appends all the points of the current generation, once evaluated.
+   Returns 0 if the file could not grow, the archive then being left as it
+   was and flagged as failed.
+ */
+extern int
+ekArchive_append(ekArchive* self, const ekOptimizer* optim);
+
+
+
+/*
+   Observer appending each generation, the data being the archive. A
+   generation which could not be added is reported by ekArchive_failed.
+ */
+extern void
+ekArchive_observe(void* data, const ekOptimizer* optim, const ekGenerationView* view);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_ARCHIVE_H */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_ARENA_H
+#define ESKIT_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+
+
+
+/*
+   Implements a memory arena : a single caller-provided memory block, carved
+   in consecutive allocations aligned on ESKIT_ARENA_ALIGNMENT bytes. The
+   allocations are never released one by one, the whole block is released by
+   its owner once it is no longer used.
+ */
+
+#define ESKIT_ARENA_ALIGNMENT 64
+
+
+
+typedef struct {
+	char* memory;
+	size_t size;
+	size_t used;
+} ekArena;
+
+
+
+#define ekArena_used(self) (self)->used
+
+#define ekArena_remaining(self) ((self)->size - (self)->used)
+
+#define ekArena_alignedSize(size) ((((size) + ESKIT_ARENA_ALIGNMENT - 1) / ESKIT_ARENA_ALIGNMENT) * ESKIT_ARENA_ALIGNMENT)
+
+#define ekArena_newArray(self, type, n) (type*)ekArena_alloc((self), (n) * sizeof(type))
+
+
+
+/* An unaligned memory block needs ESKIT_ARENA_ALIGNMENT - 1 extra bytes */
+extern void
+ekArena_init(ekArena* self, void* memory, size_t size);
+
+
+
+/* Returns NULL if the arena is exhausted. A NULL arena allocates with malloc */
+extern void*
+ekArena_alloc(ekArena* self, size_t size);
+
+
+
+/* Forgets all the allocations */
+extern void
+ekArena_reset(ekArena* self);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_ARENA_H */
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_BATCH_CMA_H
+#define ESKIT_BATCH_CMA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <eskit/Matrix.h>
+#include <eskit/Randomizer.h>
+#include <eskit/EigenSolver.h>
+#include <eskit/CMAConstants.h>
+#include <eskit/StopCriterionId.h>
+
+
+
+/*
+   Runs K independent CMA-ES instances of the same small dimension N in
+   lockstep, all of them sampling, being evaluated and updated together.
+
+   The states are stored instance-major : the element i of a vector is an
+   array of contiguous values, one per instance, so that every step of the
+   algorithm is a loop over the instances that the compiler can vectorize.
+   Those arrays have stride values, K rounded up to a whole number of SIMD
+   lanes. Vectors are N x stride arrays, matrices N x N x stride and
+   populations lambda x N x stride. Up to N = 8, the eigen decomposition is
+   a cyclic Jacobi run on all the instances at once. Above, where the sweeps
+   cost more than they save, each instance is decomposed in turn by an eigen
+   solver.
+
+   An instance which meets a stop criterion is frozen, its step length being
+   set to 0, while the others keep running.
+ */
+
+#define ESKIT_BATCH_CMA_MAX_N 16
+
+typedef struct {
+	size_t K;
+	size_t stride;
+	size_t N;
+	size_t mu;
+	size_t lambda;
+
+	double sigmaInit;
+	double sigmaStop;
+	double* weights;
+	ekCMAConstants constants;
+	size_t eigenUpdatePeriod;
+	size_t nbUpdates;
+	size_t nbUpdatesBestFitnessStalledLimit;
+
+	ekRandomizer randomizer;
+
+	double* sigma;                /* stride                                  */
+	double* xMean;                /* N x stride                              */
+	double* sigmaPath;            /* N x stride                              */
+	double* cPath;                /* N x stride                              */
+	double* C;                    /* N x N x stride, column-major matrices   */
+	double* B;                    /* N x N x stride                          */
+	double* D;                    /* N x stride                              */
+	double* BD;                   /* N x N x stride                          */
+
+	double* X;                    /* lambda x N x stride                     */
+	double* Z;                    /* lambda x N x stride                     */
+	double* fitnesses;            /* lambda x stride                         */
+	size_t* ranks;                /* lambda x stride, sorted point indices   */
+
+	double* bestX;                /* N x stride                              */
+	double* bestFitness;          /* stride                                  */
+	size_t* nbUpdatesBestFitnessStalled;
+	enum ekStopCriterionId* stopCriteria;
+
+	double* tmpPopulation;        /* mu x N x stride                         */
+	double* tmpMatrices;          /* 2 x N x N x stride                      */
+	double* tmpVectors;           /* 2 x N x stride                          */
+	double* tmpScalars;           /* 3 x stride                              */
+	double* tmpPoint;             /* N                                       */
+
+	ekEigenSolver eigenSolver;    /* Above N = 8, one instance at a time     */
+	ekMatrix eigenC;
+	ekMatrix eigenB;
+	double* eigenValues;
+} ekBatchCMA;
+
+
+
+#define ekBatchCMA_K(self) (self)->K
+
+#define ekBatchCMA_N(self) (self)->N
+
+#define ekBatchCMA_lambda(self) (self)->lambda
+
+#define ekBatchCMA_nbUpdates(self) (self)->nbUpdates
+
+#define ekBatchCMA_getRandomizer(self) (&((self)->randomizer))
+
+#define ekBatchCMA_fitness(self, j, k) (self)->fitnesses[(j) * (self)->stride + (k)]
+
+#define ekBatchCMA_sigma(self, k) (self)->sigma[(k)]
+
+#define ekBatchCMA_bestFitness(self, k) (self)->bestFitness[(k)]
+
+#define ekBatchCMA_stopCriterion(self, k) (self)->stopCriteria[(k)]
+
+
+
+/*
+   Runs K instances of dimension N, with lambda points and mu = lambda / 2.
+   Returns 0, allocating nothing, if N is 0 or above ESKIT_BATCH_CMA_MAX_N.
+ */
+extern int
+ekBatchCMA_init(ekBatchCMA* self, size_t K, size_t N, size_t lambda);
+
+
+
+extern void
+ekBatchCMA_destroy(ekBatchCMA* self);
+
+
+
+extern void
+ekBatchCMA_setSigma(ekBatchCMA* self, double sigmaInit, double sigmaStop);
+
+
+
+extern void
+ekBatchCMA_setXMean(ekBatchCMA* self, size_t k, const double* x);
+
+
+
+extern void
+ekBatchCMA_getXMean(const ekBatchCMA* self, size_t k, double* x);
+
+
+
+/* Copies the point j of the instance k */
+extern void
+ekBatchCMA_getPoint(const ekBatchCMA* self, size_t j, size_t k, double* x);
+
+
+
+extern void
+ekBatchCMA_getBestPoint(const ekBatchCMA* self, size_t k, double* x);
+
+
+
+extern void
+ekBatchCMA_start(ekBatchCMA* self);
+
+
+
+extern void
+ekBatchCMA_sample(ekBatchCMA* self);
+
+
+
+/* Evaluates the points of the running instances, stopped ones get HUGE_VAL */
+extern void
+ekBatchCMA_evaluateFunction(ekBatchCMA* self, double(*func)(const double*, size_t));
+
+
+
+extern void
+ekBatchCMA_update(ekBatchCMA* self);
+
+
+
+/* Checks the stop criteria, returns the number of instances still running */
+extern size_t
+ekBatchCMA_stop(ekBatchCMA* self);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_BATCH_CMA_H */
@@ -44,12 +44,16 @@ typedef struct {
 	int hasCustomCov;
 	ekMatrix B, C, BD;    /* Covariance matrix and its decomposition           */
 	double* D;
+	int implicitC;        /* If set, C is the identity and is not written yet  */
+	int implicitB;        /* If set, B and BD are the identity, and D is 1     */
 
 	double* tmpVector;    /* Intermediate results storage                      */
 
 	int eigenSolverFailure;
 	size_t eigenUpdatePeriod;
 	ekEigenSolver eigenSolver;
+
+	ekArena* arena;       /* NULL if the state is on the heap                  */
 } ekCMA;
 
 
@@ -64,11 +68,37 @@ ekCMA_init(ekCMA* self, size_t N);
 
 
 
+/*
+   Carves all the state from the arena, which destroying the instance leaves
+   alone. Returns 0 if the arena has less than ekCMA_arenaSize bytes left.
+ */
+extern int
+ekCMA_initFromArena(ekCMA* self, size_t N, ekArena* arena);
+
+
+
 extern void
 ekCMA_destroy(ekCMA* self);
 
 
 
+/* Heap memory, in bytes, allocated by ekCMA_init */
+extern size_t
+ekCMA_requiredMemory(size_t N);
+
+
+
+extern size_t
+ekCMA_memoryUsage(const ekCMA* self);
+
+
+
+/* Arena memory, in bytes, used by ekCMA_initFromArena */
+extern size_t
+ekCMA_arenaSize(size_t N);
+
+
+
 extern void
 ekCMA_setSigma(ekCMA* self, double sigmaInit, double sigmaStop);
 
@@ -89,13 +119,17 @@ ekCMA_sigma(const ekCMA* self);
 
 
 
+/*
+   Not const : the identity left implicit by the start is written on the
+   first call, until the update computes the matrix
+ */
 extern const ekMatrix*
-ekCMA_C(const ekCMA* self);
+ekCMA_C(ekCMA* self);
 
 
 
 extern const ekMatrix*
-ekCMA_B(const ekCMA* self);
+ekCMA_B(ekCMA* self);
 
 
 
@@ -14,6 +14,7 @@ extern "C" {
 
 
 
+#include <stddef.h>
 #include <eskit/Types.h>
 
 
@@ -39,6 +40,12 @@ ekCMAConstants_setup(ekCMAConstants* self, struct s_ekOptimizer* optim);
 
 
 
+/* Same as ekCMAConstants_setup, for N dimensions and mu normalized weights */
+extern void
+ekCMAConstants_setupFromWeights(ekCMAConstants* self, size_t N, const double* weights, size_t mu);
+
+
+
 #ifdef __cplusplus
 }
 #endif
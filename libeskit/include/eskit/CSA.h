@@ -13,6 +13,7 @@ extern "C" {
 #endif
 
 
+#include <eskit/Arena.h>
 #include <eskit/Distribution.h>
 
 
@@ -30,6 +31,8 @@ extern "C" {
  */
 
 typedef struct {
+	size_t N;
+
 	double sigmaInit;
 	double sigmaStop;
 
@@ -37,6 +40,8 @@ typedef struct {
 	double c;           /* Cumulation parameter                               */
 	double dampening;   /* Adaption dampening                                 */
 	double* sigmaPath;  /* Evolution path for sigma                           */
+
+	ekArena* arena;     /* NULL if the state is on the heap                   */
 } ekCSA;
 
 
@@ -51,11 +56,37 @@ ekCSA_init(ekCSA* self, size_t N);
 
 
 
+/*
+   Carves all the state from the arena, which destroying the instance leaves
+   alone. Returns 0 if the arena has less than ekCSA_arenaSize bytes left.
+ */
+extern int
+ekCSA_initFromArena(ekCSA* self, size_t N, ekArena* arena);
+
+
+
 extern void
 ekCSA_destroy(ekCSA* self);
 
 
 
+/* Heap memory, in bytes, allocated by ekCSA_init */
+extern size_t
+ekCSA_requiredMemory(size_t N);
+
+
+
+extern size_t
+ekCSA_memoryUsage(const ekCSA* self);
+
+
+
+/* Arena memory, in bytes, used by ekCSA_initFromArena */
+extern size_t
+ekCSA_arenaSize(size_t N);
+
+
+
 extern void
 ekCSA_setSigma(ekCSA* self, double sigmaInit, double sigmaStop);
 
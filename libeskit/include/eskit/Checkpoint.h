@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_CHECKPOINT_H
+#define ESKIT_CHECKPOINT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <eskit/Matrix.h>
+#include <eskit/Randomizer.h>
+
+
+
+/*
+   Binary serialization helpers, used to save and restore the state of an
+   optimizer and of its point distribution.
+
+   Values are stored with the native byte order and floating point format, a
+   checkpoint is meant to be restored on the same kind of machine. Vectors and
+   matrices are written and read with one single call, straight from and to
+   their storage. All the functions return 0 on failure, a non-zero value
+   otherwise.
+ */
+
+#define ESKIT_CHECKPOINT_MAGIC 0x4b53456bu   /* "kESK" when read on little endian */
+
+#define ESKIT_CHECKPOINT_VERSION 4u
+
+
+
+extern int
+ekCheckpoint_write(FILE* file, const void* data, size_t size);
+
+
+
+extern int
+ekCheckpoint_read(FILE* file, void* data, size_t size);
+
+
+
+extern int
+ekCheckpoint_writeSize(FILE* file, size_t value);
+
+
+
+extern int
+ekCheckpoint_readSize(FILE* file, size_t* value);
+
+
+
+extern int
+ekCheckpoint_writeDouble(FILE* file, double value);
+
+
+
+extern int
+ekCheckpoint_readDouble(FILE* file, double* value);
+
+
+
+extern int
+ekCheckpoint_writeString(FILE* file, const char* str);
+
+
+
+/* Reads a string and checks it is equal to str */
+extern int
+ekCheckpoint_checkString(FILE* file, const char* str);
+
+
+
+extern int
+ekCheckpoint_writeArray(FILE* file, const double* u, size_t size);
+
+
+
+extern int
+ekCheckpoint_readArray(FILE* file, double* u, size_t size);
+
+
+
+extern int
+ekCheckpoint_writeMatrix(FILE* file, const ekMatrix* M);
+
+
+
+/* Fails if the stored matrix and M have different dimensions */
+extern int
+ekCheckpoint_readMatrix(FILE* file, ekMatrix* M);
+
+
+
+extern int
+ekCheckpoint_writeRandomizer(FILE* file, const ekRandomizer* randomizer);
+
+
+
+/* Fails if the stored randomizer does not have the same size */
+extern int
+ekCheckpoint_readRandomizer(FILE* file, ekRandomizer* randomizer);
+
+
+
+/* Reads past a stored randomizer of any size, without allocating */
+extern int
+ekCheckpoint_skipRandomizer(FILE* file);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_CHECKPOINT_H */
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_CLOCK_H
+#define ESKIT_CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/* Seconds elapsed since an arbitrary origin, from a monotonic clock */
+extern double
+ekClock_now(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_CLOCK_H */
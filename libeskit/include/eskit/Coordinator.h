@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_COORDINATOR_H
+#define ESKIT_COORDINATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <eskit/Types.h>
+
+
+
+/*
+   Implements the evaluation of the points by remote workers, connected to
+   the coordinator through TCP or Unix sockets. The points are sent by
+   batches, several batches being in flight on each connection. The batches
+   of a worker which disconnects are sent again to the other workers.
+
+   An address is either "unix:PATH" or "HOST:PORT", an empty HOST or "*"
+   listening on all the interfaces. Each message starts with four little
+   endian 32 bits integers (type, a, b, c), followed by little endian IEEE 754
+   doubles :
+
+     Hello  (0, magic, version, N)   sent by both sides on connection, the
+                                     worker sending N = 0
+     Batch  (1, tag, first, count)   count points of N doubles
+     Result (2, tag, first, count)   count fitnesses
+     Bye    (3, 0, 0, 0)             the worker should exit
+
+   The tag identifies the generation, results of another generation are
+   ignored. The points first to first + count - 1 are the columns of the
+   population matrix.
+ */
+
+#define ESKIT_COORDINATOR_MAGIC 0x574b5345 /* "ESKW" */
+
+#define ESKIT_COORDINATOR_VERSION 1
+
+
+
+struct s_ekCoordinatorLink;
+
+
+
+typedef struct {
+	size_t N;
+	size_t batchSize;            /* Points per batch                          */
+	size_t depth;                /* Batches in flight per worker              */
+	int listenFd;
+	char* unixPath;              /* Removed on destroy, NULL for TCP          */
+	struct s_ekCoordinatorLink* links;
+	size_t nbLinks;
+	size_t linksCapacity;
+	uint32_t tag;
+	size_t* pending;             /* Batches to send, as a stack               */
+	double* fitnesses;           /* Fitnesses of the points, in column order  */
+	size_t capacity;
+	size_t nbRedispatches;
+} ekCoordinator;
+
+
+
+#define ekCoordinator_nbRedispatches(self) (self)->nbRedispatches
+
+
+
+/*
+   Listens on address for workers evaluating points of dimension N, by
+   batches of batchSize points, with up to depth batches in flight per
+   worker. Returns 0 on failure.
+ */
+extern int
+ekCoordinator_init(ekCoordinator* self, const char* address, size_t N, size_t batchSize, size_t depth);
+
+
+
+/* Sends a bye to the workers and closes all the connections */
+extern void
+ekCoordinator_destroy(ekCoordinator* self);
+
+
+
+/* Number of connected workers */
+extern size_t
+ekCoordinator_nbWorkers(const ekCoordinator* self);
+
+
+
+/*
+   Sets the fitness of all the points of the optimizer, accepting the new
+   workers meanwhile. Returns 0 if nothing happened during timeout seconds,
+   HUGE_VAL to wait forever, the fitnesses being then left as is.
+ */
+extern int
+ekCoordinator_evaluate(ekCoordinator* self, ekOptimizer* optim, double timeout);
+
+
+
+/*
+   Connects a worker to a coordinator at address, and evaluates its batches
+   with function until the coordinator says bye. Returns 0 if the connection
+   failed or was lost.
+ */
+extern int
+ekCoordinator_runWorker(const char* address, double(*function)(const double*, size_t));
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_COORDINATOR_H */
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_COROUTINE_HPP
+#define ESKIT_COROUTINE_HPP
+
+#if __cplusplus < 202002L
+#error "eskit/Coroutine.hpp requires C++20"
+#endif
+
+
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <eskit/Optimizer.h>
+#include <eskit/StopCriterionId.h>
+
+
+
+/*
+   Header-only C++20 wrapper driving an optimizer from a coroutine. The
+   optimize coroutine samples a generation, co_awaits an asynchronous batch
+   evaluator, then updates the optimizer, so that the optimization does not
+   hold a thread while the points are evaluated. Many optimizations can then
+   share the few threads of an executor.
+
+   The coroutines are lazy, and run on the thread which resumes them : the
+   sampling and the update of a generation run on the thread resuming the
+   awaitable returned by the evaluator. The library itself knows nothing
+   about executors.
+ */
+
+namespace eskit {
+
+
+
+/* --- Task ---------------------------------------------------------------- */
+
+template<typename T = void>
+class Task;
+
+
+
+namespace detail {
+
+/* Resumes the awaiting coroutine, if any, once the task is done */
+struct FinalAwaiter {
+	bool await_ready() const noexcept { return false; }
+
+	template<typename Promise>
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+		std::coroutine_handle<> continuation = handle.promise().continuation;
+		return continuation ? continuation : std::noop_coroutine();
+	}
+
+	void await_resume() const noexcept { }
+};
+
+
+
+struct PromiseBase {
+	std::coroutine_handle<> continuation;
+	std::exception_ptr exception;
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+
+	void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+
+
+template<typename T>
+struct Promise : PromiseBase {
+	std::optional<T> value;
+
+	Task<T> get_return_object() noexcept;
+
+	template<typename U>
+	void return_value(U&& ret) { value.emplace(std::forward<U>(ret)); }
+
+	T result() {
+		if (exception)
+			std::rethrow_exception(exception);
+		return std::move(*value);
+	}
+};
+
+
+
+template<>
+struct Promise<void> : PromiseBase {
+	Task<void> get_return_object() noexcept;
+
+	void return_void() const noexcept { }
+
+	void result() {
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+};
+
+} // namespace detail
+
+
+
+/*
+   A lazy coroutine returning a T. It starts when co_awaited, the awaiting
+   coroutine being resumed once it is done, with no thread switch.
+ */
+template<typename T>
+class Task {
+	public:
+		using promise_type = detail::Promise<T>;
+
+		explicit Task(std::coroutine_handle<promise_type> coroutine) noexcept : handle(coroutine) { }
+
+		Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) { }
+
+		Task& operator=(Task&& other) noexcept {
+			if (this != &other) {
+				if (handle)
+					handle.destroy();
+				handle = std::exchange(other.handle, nullptr);
+			}
+			return *this;
+		}
+
+		Task(const Task&) = delete;
+
+		Task& operator=(const Task&) = delete;
+
+		~Task() {
+			if (handle)
+				handle.destroy();
+		}
+
+		auto operator co_await() && noexcept {
+			struct Awaiter {
+				std::coroutine_handle<promise_type> handle;
+
+				bool await_ready() const noexcept { return false; }
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume() { return handle.promise().result(); }
+			};
+
+			return Awaiter{handle};
+		}
+
+	private:
+		std::coroutine_handle<promise_type> handle;
+};
+
+
+
+namespace detail {
+
+template<typename T>
+inline Task<T>
+Promise<T>::get_return_object() noexcept {
+	return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+
+
+inline Task<void>
+Promise<void>::get_return_object() noexcept {
+	return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+
+
+/* Eager coroutine freeing itself when done, for spawn */
+struct Detached {
+	struct promise_type {
+		Detached get_return_object() const noexcept { return {}; }
+
+		std::suspend_never initial_suspend() const noexcept { return {}; }
+
+		std::suspend_never final_suspend() const noexcept { return {}; }
+
+		void return_void() const noexcept { }
+
+		void unhandled_exception() const noexcept { std::terminate(); }
+	};
+};
+
+
+
+template<typename T, typename Callback>
+Detached
+runDetached(Task<T> task, Callback done) {
+	if constexpr (std::is_void_v<T>) {
+		co_await std::move(task);
+		done();
+	}
+	else
+		done(co_await std::move(task));
+}
+
+} // namespace detail
+
+
+
+/*
+   Starts a task in the calling thread, without waiting for it. Once the task
+   is done, done is called with its result, or with no argument for a void
+   task, from the thread which completed it. An exception escaping the task
+   terminates the program.
+ */
+template<typename T, typename Callback>
+inline void
+spawn(Task<T> task, Callback done) {
+	detail::runDetached(std::move(task), std::move(done));
+}
+
+
+
+/* Starts a task and blocks the calling thread until it is done */
+template<typename T>
+inline T
+syncWait(Task<T> task) {
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool finished = false;
+	std::exception_ptr exception;
+	std::optional<std::conditional_t<std::is_void_v<T>, char, T>> value;
+
+	auto wrapper = [&]() -> Task<void> {
+		try {
+			if constexpr (std::is_void_v<T>)
+				co_await std::move(task);
+			else
+				value.emplace(co_await std::move(task));
+		}
+		catch(...) {
+			exception = std::current_exception();
+		}
+	};
+
+	eskit::spawn(wrapper(), [&]() {
+		std::lock_guard<std::mutex> lock(mutex);
+		finished = true;
+		cond.notify_one();
+	});
+
+	std::unique_lock<std::mutex> lock(mutex);
+	cond.wait(lock, [&]() { return finished; });
+
+	if (exception)
+		std::rethrow_exception(exception);
+	if constexpr (!std::is_void_v<T>)
+		return std::move(*value);
+}
+
+
+
+/* --- Optimization -------------------------------------------------------- */
+
+/*
+   The points of a generation to evaluate. The fitness of point i, column i
+   of the population matrix, is written to fitnesses[i].
+ */
+struct Batch {
+	const ekMatrix* points;
+	std::size_t N;
+	std::size_t lambda;
+	double* fitnesses;
+
+	const double* point(std::size_t i) const { return ekMatrix_col(points, i); }
+};
+
+
+
+/*
+   Starts the optimizer, then runs generations until it stops, returning the
+   stop criterion. evaluate(batch) should return an awaitable, which fills
+   the fitnesses of the batch before resuming. The points and the fitnesses
+   stay valid until then. The optimizer should be set up beforehand, and
+   outlive the task. An optimizer should only be driven by one task at a time.
+ */
+template<typename Evaluator>
+Task<enum ekStopCriterionId>
+optimize(ekOptimizer& optim, Evaluator evaluate) {
+	enum ekStopCriterionId stop;
+	std::vector<double> fitnesses;
+
+	ekOptimizer_start(&optim);
+
+	do {
+		ekOptimizer_sampleCloud(&optim);
+
+		fitnesses.resize(ekOptimizer_lambda(&optim));
+		co_await evaluate(Batch{&optim.X, ekOptimizer_N(&optim), ekOptimizer_lambda(&optim), fitnesses.data()});
+
+		ekOptimizer_setFitnesses(&optim, fitnesses.data());
+		ekOptimizer_update(&optim);
+		stop = ekOptimizer_stop(&optim);
+	} while(stop == ekStopCriterionId_None);
+
+	co_return stop;
+}
+
+} // namespace eskit
+
+#endif /* ESKIT_COROUTINE_HPP */
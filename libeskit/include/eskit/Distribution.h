@@ -14,8 +14,10 @@ extern "C" {
 
 
 
+#include <stdio.h>
 #include <eskit/Types.h>
 #include <eskit/StopCriterionId.h>
+#include <eskit/Observer.h>
 
 
 
@@ -37,6 +39,18 @@ typedef struct {
 
 	/* Test if further updates are possible */
 	enum ekStopCriterionId(*stop)(ekDistribution*, ekOptimizer*);
+
+	/* Write the distribution state to a checkpoint, returns 0 on failure */
+	int(*save)(ekDistribution*, ekOptimizer*, FILE*);
+
+	/* Read the distribution state from a checkpoint, returns 0 on failure */
+	int(*load)(ekDistribution*, ekOptimizer*, FILE*);
+
+	/* Fill the step length and axes lengths of a generation view */
+	void(*view)(ekDistribution*, ekOptimizer*, ekGenerationView*);
+
+	/* Compute the z of a point which was not sampled by the distribution */
+	void(*project)(ekDistribution*, ekOptimizer*, const double*, double*);
 } ekDistributionDelegate;
 
 
@@ -58,6 +72,14 @@ struct s_ekDistribution {
 
 #define ekDistribution_stop(self, optim) (self)->delegate.stop((self), (optim))
 
+#define ekDistribution_save(self, optim, file) (self)->delegate.save((self), (optim), (file))
+
+#define ekDistribution_load(self, optim, file) (self)->delegate.load((self), (optim), (file))
+
+#define ekDistribution_view(self, optim, generationView) (self)->delegate.view((self), (optim), (generationView))
+
+#define ekDistribution_project(self, optim, x, z) (self)->delegate.project((self), (optim), (x), (z))
+
 
 
 #ifdef __cplusplus
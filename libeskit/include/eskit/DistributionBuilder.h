@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_DISTRIBUTION_BUILDER_H
+#define ESKIT_DISTRIBUTION_BUILDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <eskit/Distribution.h>
+
+
+
+/*
+   Creates and destroys point distribution handlers of a given kind. Used when
+   a piece of code needs its own distribution instances, without knowing their
+   concrete type (restarts, islands, ...).
+ */
+
+typedef struct {
+	void*(*create)(size_t N, double sigmaInit, double sigmaStop);
+	void(*destroy)(void*);
+	const ekDistributionDelegate* delegate;
+
+	/* Heap memory, in bytes, allocated by create */
+	size_t(*requiredMemory)(size_t N);
+} ekDistributionBuilder;
+
+
+
+extern const ekDistributionBuilder ekCSA_DistributionBuilder;
+extern const ekDistributionBuilder ekCMA_DistributionBuilder;
+extern const ekDistributionBuilder ekSepCMA_DistributionBuilder;
+
+
+
+/* Returns NULL if no builder have such a name */
+extern const ekDistributionBuilder*
+ekDistributionBuilder_byName(const char* name);
+
+
+
+/* Heap memory, in bytes, needed to optimize with N and lambda using a builder */
+extern size_t
+ekDistributionBuilder_requiredMemory(const ekDistributionBuilder* self, size_t N, size_t lambda);
+
+
+
+extern void
+ekDistribution_initFromBuilder(ekDistribution* self, const ekDistributionBuilder* builder, size_t N, double sigmaInit, double sigmaStop);
+
+
+
+extern void
+ekDistribution_destroy(ekDistribution* self, const ekDistributionBuilder* builder);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_DISTRIBUTION_BUILDER_H */
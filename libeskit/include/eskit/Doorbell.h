@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_DOORBELL_H
+#define ESKIT_DOORBELL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stdint.h>
+#include <pthread.h>
+
+
+
+/*
+   Implements a doorbell : a counter incremented each time the bell rings,
+   which other threads or processes can wait for. A doorbell placed in shared
+   memory works across processes, even if a process dies while ringing.
+   Waiting for a change of the counter since a known value never misses a
+   ring done after the data was checked :
+
+     count = ekDoorbell_count(bell);
+     while(!dataReady)
+       count = ekDoorbell_wait(bell, count, timeout);
+ */
+
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	uint32_t count;
+} ekDoorbell;
+
+
+
+/* The doorbell can be shared between processes if it is in shared memory */
+extern void
+ekDoorbell_init(ekDoorbell* self);
+
+
+
+extern void
+ekDoorbell_destroy(ekDoorbell* self);
+
+
+
+/*
+   Guards the data signaled by the doorbell, so that data written by a
+   process is complete once seen by another. Not held while ringing.
+ */
+extern void
+ekDoorbell_lock(ekDoorbell* self);
+
+
+
+extern void
+ekDoorbell_unlock(ekDoorbell* self);
+
+
+
+/* Increments the counter, waking up all the waiters */
+extern void
+ekDoorbell_ring(ekDoorbell* self);
+
+
+
+extern uint32_t
+ekDoorbell_count(ekDoorbell* self);
+
+
+
+/*
+   Waits until the counter differs from count, or for at most timeout
+   seconds, HUGE_VAL to wait forever. Returns the counter.
+ */
+extern uint32_t
+ekDoorbell_wait(ekDoorbell* self, uint32_t count, double timeout);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_DOORBELL_H */
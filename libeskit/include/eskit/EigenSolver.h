@@ -19,6 +19,8 @@ extern "C" {
 
 
 typedef struct {
+	size_t size;
+
 #ifdef USE_LAPACK
 	char JOBZ;
 	char UPLO;
@@ -37,11 +39,34 @@ ekEigenSolver_init(ekEigenSolver* self, size_t size);
 
 
 
+/* The arena should have at least ekEigenSolver_arenaSize bytes left */
+extern void
+ekEigenSolver_initFromArena(ekEigenSolver* self, size_t size, ekArena* arena);
+
+
+
 extern void
 ekEigenSolver_destroy(ekEigenSolver* self);
 
 
 
+/* Heap memory, in bytes, allocated by ekEigenSolver_init */
+extern size_t
+ekEigenSolver_requiredMemory(size_t size);
+
+
+
+extern size_t
+ekEigenSolver_memoryUsage(const ekEigenSolver* self);
+
+
+
+/* Arena memory, in bytes, used by ekEigenSolver_initFromArena */
+extern size_t
+ekEigenSolver_arenaSize(size_t size);
+
+
+
 extern int
 ekEigenSolver_solve(ekEigenSolver* self, const ekMatrix* M, ekMatrix* vectors, double* values);
 
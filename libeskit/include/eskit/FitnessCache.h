@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_FITNESS_CACHE_H
+#define ESKIT_FITNESS_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+
+
+/*
+   Implements a bounded cache of fitness values, indexed by points. When full,
+   the least recently used entry is evicted.
+
+   With a non-zero quantum, the coordinates are rounded to a multiple of the
+   quantum before being used as a key : all the points in the same cell share
+   the fitness of the first point evaluated in that cell.
+ */
+
+typedef struct {
+	size_t N;
+	size_t capacity;
+	double quantum;
+
+	size_t nbEntries;
+	double* keys;          /* capacity keys of N coordinates                   */
+	double* fitnesses;
+	uint64_t* hashes;
+
+	size_t* older;         /* Doubly linked list, from most to least recently  */
+	size_t* newer;         /* used entries                                     */
+	size_t mostRecent;
+	size_t leastRecent;
+
+	size_t nbBuckets;      /* Hash table, chaining the entries of a bucket     */
+	size_t* buckets;
+	size_t* chain;
+
+	size_t nbHits;
+	size_t nbMisses;
+
+	double* tmpKey;
+} ekFitnessCache;
+
+
+
+#define ekFitnessCache_nbEntries(self) (self)->nbEntries
+
+#define ekFitnessCache_nbHits(self) (self)->nbHits
+
+#define ekFitnessCache_nbMisses(self) (self)->nbMisses
+
+
+
+extern void
+ekFitnessCache_init(ekFitnessCache* self, size_t N, size_t capacity);
+
+
+
+extern void
+ekFitnessCache_destroy(ekFitnessCache* self);
+
+
+
+/* Should be done while the cache is empty */
+extern void
+ekFitnessCache_setQuantum(ekFitnessCache* self, double quantum);
+
+
+
+/* Removes all the entries and resets the hit counters */
+extern void
+ekFitnessCache_clear(ekFitnessCache* self);
+
+
+
+/* Returns 1 and sets fitness if x is in the cache, 0 otherwise */
+extern int
+ekFitnessCache_lookup(ekFitnessCache* self, const double* x, double* fitness);
+
+
+
+extern void
+ekFitnessCache_insert(ekFitnessCache* self, const double* x, double fitness);
+
+
+
+/* Ratio of lookups that were hits */
+extern double
+ekFitnessCache_hitRate(const ekFitnessCache* self);
+
+
+
+/* Writes all the entries, returns 0 on failure */
+extern int
+ekFitnessCache_save(const ekFitnessCache* self, FILE* file);
+
+
+
+/* Adds the entries written by ekFitnessCache_save, returns 0 on failure */
+extern int
+ekFitnessCache_load(ekFitnessCache* self, FILE* file);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_FITNESS_CACHE_H */
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_ISLANDS_H
+#define ESKIT_ISLANDS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <eskit/Randomizer.h>
+#include <eskit/ThreadPool.h>
+#include <eskit/DistributionBuilder.h>
+
+
+
+/*
+   Implements an island model : several optimizations run side by side, each
+   with its own optimizer and distribution, and every few generations the
+   best points of an island migrate to the next island of a ring. A migrant
+   replaces the worst point of a generation before the update. An island
+   whose optimizer stops restarts from the initial distribution, so that it
+   keeps receiving its migrants until its share of the budget is spent.
+
+   When a thread pool is set, each island runs on its own task, without any
+   synchronization between the islands : the migrants go through single
+   producer single consumer mailboxes, and an island never waits for its
+   migrants. The thread pool should have at least one thread per island, so
+   that the islands progress together. Without thread pool, the islands
+   take turns, one generation at a time.
+ */
+
+#define ESKIT_ISLANDS_MAILBOX_SIZE 8
+
+
+
+struct s_ekIsland;
+
+
+
+typedef struct {
+	size_t N;
+	size_t nbIslands;
+	const ekDistributionBuilder* builder;
+
+	double sigmaInit;
+	double sigmaStop;
+	size_t lambda;
+	double* xMeanInit;
+
+	size_t migrationPeriod;    /* Generations between two migrations          */
+	size_t nbMigrants;         /* Best points sent at each migration          */
+
+	size_t maxEvaluations;     /* Shared evenly among the islands             */
+	double targetFitness;
+
+	ekThreadPool* threadPool;
+	ekRandomizer randomizer;
+
+	struct s_ekIsland* islands;
+	int done;                  /* Set atomically once the target is reached   */
+
+	/* Results of the last run */
+	size_t nbEvaluations;
+	size_t nbMigrations;       /* Migrants injected in a generation           */
+	size_t nbDropped;          /* Migrants lost to a full mailbox             */
+	size_t nbRestarts;         /* Runs restarted by a stopped island          */
+	double* bestX;
+	double bestFitness;
+} ekIslands;
+
+
+
+#define ekIslands_nbIslands(self) (self)->nbIslands
+
+#define ekIslands_xMeanInit(self) (self)->xMeanInit
+
+#define ekIslands_getRandomizer(self) &((self)->randomizer)
+
+#define ekIslands_nbEvaluations(self) (self)->nbEvaluations
+
+#define ekIslands_nbMigrations(self) (self)->nbMigrations
+
+#define ekIslands_nbDropped(self) (self)->nbDropped
+
+#define ekIslands_nbRestarts(self) (self)->nbRestarts
+
+#define ekIslands_bestX(self) (self)->bestX
+
+#define ekIslands_bestFitness(self) (self)->bestFitness
+
+
+
+extern void
+ekIslands_init(ekIslands* self, size_t N, size_t nbIslands, const ekDistributionBuilder* builder);
+
+
+
+extern void
+ekIslands_destroy(ekIslands* self);
+
+
+
+extern void
+ekIslands_setSigma(ekIslands* self, double sigmaInit, double sigmaStop);
+
+
+
+/* Population size of each island, the default is the optimizer default */
+extern void
+ekIslands_setLambda(ekIslands* self, size_t lambda);
+
+
+
+/* The nbMigrants best points of an island migrate every period generations */
+extern void
+ekIslands_setMigration(ekIslands* self, size_t period, size_t nbMigrants);
+
+
+
+extern void
+ekIslands_setBudget(ekIslands* self, size_t maxEvaluations);
+
+
+
+extern void
+ekIslands_setTargetFitness(ekIslands* self, double targetFitness);
+
+
+
+extern void
+ekIslands_setThreadPool(ekIslands* self, ekThreadPool* pool);
+
+
+
+/* The function should be thread-safe if a thread pool is set */
+extern void
+ekIslands_run(ekIslands* self, double(*function)(const double*, size_t));
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_ISLANDS_H */
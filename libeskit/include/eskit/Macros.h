@@ -33,4 +33,18 @@
 
 
 
+
+/*
+   Aligns a structure member on n bytes, and thus the structure itself
+ */
+
+#ifdef ESKIT_ALIGNED
+#elif defined(__GNUC__)
+  #define ESKIT_ALIGNED(n) __attribute__((aligned(n)))
+#else
+  #define ESKIT_ALIGNED(n)
+#endif
+
+
+
 #endif /* ESKIT_MACROS_H */
@@ -17,6 +17,7 @@ extern "C" {
 #include <stdio.h>
 #include <eskit/Types.h>
 #include <eskit/Randomizer.h>
+#include <eskit/Arena.h>
 
 
 
@@ -56,11 +57,45 @@ ekMatrix_init(ekMatrix* self, size_t nbCols, size_t nbRows);
 
 
 
+/* The arena should have at least ekMatrix_arenaSize bytes left */
+extern void
+ekMatrix_initFromArena(ekMatrix* self, size_t nbCols, size_t nbRows, ekArena* arena);
+
+
+
+/* Matrices with at least nbElements elements are processed by several threads */
+extern void
+ekMatrix_setParallelThreshold(size_t nbElements);
+
+
+
+extern size_t
+ekMatrix_parallelThreshold(void);
+
+
+
 extern void
 ekMatrix_destroy(ekMatrix* self);
 
 
 
+/* Heap memory, in bytes, allocated by ekMatrix_init */
+extern size_t
+ekMatrix_requiredMemory(size_t nbCols, size_t nbRows);
+
+
+
+extern size_t
+ekMatrix_memoryUsage(const ekMatrix* self);
+
+
+
+/* Arena memory, in bytes, used by ekMatrix_initFromArena */
+extern size_t
+ekMatrix_arenaSize(size_t nbCols, size_t nbRows);
+
+
+
 /* Computes self = U */
 extern void
 ekMatrix_copy(ekMatrix* self, const ekMatrix* u);
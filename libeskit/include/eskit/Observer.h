@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_OBSERVER_H
+#define ESKIT_OBSERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <eskit/Types.h>
+
+
+
+/*
+   Read-only view of an optimizer after an update. The arrays are owned by the
+   optimizer and are only valid during the observer call.
+ */
+
+typedef struct {
+	size_t nbUpdates;
+	size_t nbEvaluations;
+	size_t lambda;
+
+	const double* bestX;           /* Best point since the optimizer start     */
+	double bestFitness;
+	double generationBestFitness;  /* Best fitness of the last generation      */
+	const double* xMean;
+
+	/* Filled by the distribution */
+	double sigma;                  /* Step length                              */
+	double DMin;                   /* Shortest and longest axis of the         */
+	double DMax;                   /* distribution, 1 if isotropic             */
+} ekGenerationView;
+
+
+
+typedef void(*ekObserverFunc)(void* data, const ekOptimizer* optim, const ekGenerationView* view);
+
+
+
+typedef struct {
+	ekObserverFunc func;
+	void* data;
+} ekObserver;
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_OBSERVER_H */
@@ -14,8 +14,26 @@ extern "C" {
 
 
 
+#include <stdio.h>
 #include <eskit/Distribution.h>
+#include <eskit/Arena.h>
+#include <eskit/Matrix.h>
 #include <eskit/Randomizer.h>
+#include <eskit/ThreadPool.h>
+#include <eskit/FitnessCache.h>
+#include <eskit/Profile.h>
+#include <eskit/Trace.h>
+
+
+
+/* The coordinate-major points are padded to a multiple of this number of points */
+#define ESKIT_POINT_LANES 8
+
+/* Number of observers of an optimizer carved from an arena */
+#define ESKIT_ARENA_OBSERVERS 8
+
+/* Number of thread pool workers of an optimizer carved from an arena */
+#define ESKIT_ARENA_BLOCKS 16
 
 
 
@@ -23,6 +41,8 @@ typedef struct {
 	double* x;
 	double* z;
 	double fitness;
+	int aborted;   /* If set, the evaluation was aborted and fitness is a lower bound */
+	int cached;    /* If set, the fitness was found in the cache, in deterministic mode */
 } ekPoint;
 
 
@@ -48,16 +68,62 @@ struct s_ekOptimizer {
 	ekPoint** points;
 	size_t nbPointsMax;
 	ekPoint bestPoint;
+	double* racingFitnesses;        /* mu best exact fitnesses while racing    */
+	size_t nbAborted;
 
 	size_t nbUpdatesBestFitnessStalled;
 	size_t nbUpdatesBestFitnessStalledLimit;
 
 	ekRandomizer randomizer;
 	ekDistribution distrib;
+
+	ekThreadPool* threadPool;
+	ekRandomizer* blockRandomizers; /* One random stream per sampling block    */
+	size_t nbBlocks;
+	int started;                    /* Block streams are seeded by the start  */
+	int deterministic;              /* Sampling independent from the threads  */
+	ekRandomizer* pointRandomizers; /* One random stream per point            */
+	size_t nbPointRandomizers;
+	double evaluationCost;          /* Average time of a parallel evaluation   */
+
+	ekFitnessCache* fitnessCache;   /* Optional, looked up before evaluations */
+	size_t nbCacheHits;             /* Points of the generation found in it    */
+
+	size_t nbEvaluations;
+	size_t maxEvaluations;          /* 0 for no evaluation budget              */
+	double deadline;                /* ekClock_now time, HUGE_VAL for none     */
+	double lastUpdateTime;
+	double pointCost;               /* Average time of a generation, per point */
+	int lambdaShrinking;
+	size_t configuredLambda;        /* Lambda restored by the start            */
+
+	ekProfile profile;
+
+	ekObserver* observers;
+	size_t nbObservers;
+	size_t observersCapacity;
+
+	ekTrace* trace;                 /* Optional, records the phases            */
+
+	ekArena* arena;                 /* NULL if the state is on the heap        */
+
+	void* coordsMemory;             /* Holds coords, NULL until first used     */
+	ekMatrix coords;                /* Column i is the coordinate i of X       */
+	double* coordsFitnesses;
 };
 
 
 
+/*
+   Samples the columns [begin, end[ of the x and z matrices, drawing random 
+   numbers from a given randomizer. Used by the distributions to split a cloud 
+   sampling among the workers of the optimizer thread pool.
+ */
+
+typedef void(*ekSampleBlockFunc)(void* data, ekOptimizer* optim, ekRandomizer* randomizer, ekMatrix* x, ekMatrix* z, size_t begin, size_t end);
+
+
+
 #define ekOptimizer_N(self) (self)->N
 
 #define ekOptimizer_mu(self) (self)->mu
@@ -78,6 +144,20 @@ struct s_ekOptimizer {
 
 #define ekOptimizer_getRandomizer(self) &((self)->randomizer)
 
+#define ekOptimizer_threadPool(self) (self)->threadPool
+
+#define ekOptimizer_fitnessCache(self) (self)->fitnessCache
+
+#define ekOptimizer_nbEvaluations(self) (self)->nbEvaluations
+
+#define ekOptimizer_nbAborted(self) (self)->nbAborted
+
+#define ekOptimizer_profile(self) (&((self)->profile))
+
+#define ekOptimizer_trace(self) (self)->trace
+
+#define ekOptimizer_generationCost(self) ((self)->pointCost * (self)->lambda)
+
 
 
 extern void
@@ -85,12 +165,50 @@ ekOptimizer_init(ekOptimizer* self, size_t N);
 
 
 
+/*
+   Carves all the state for up to lambda points from the arena, which should
+   outlive the optimizer. Returns 0 if the arena has less than
+   ekOptimizer_arenaSize bytes left. A NULL arena allocates on the heap.
+ */
+extern int
+ekOptimizer_initFromArena(ekOptimizer* self, size_t N, size_t lambda, ekArena* arena);
+
+
+
 extern void
 ekOptimizer_destroy(ekOptimizer* self);
 
 
 
+/*
+   Restores the settings of a freshly initialized optimizer, keeping its
+   allocations, its population size, its distribution and its random stream
+ */
 extern void
+ekOptimizer_reset(ekOptimizer* self);
+
+
+
+/* Heap memory, in bytes, allocated by ekOptimizer_init and a start with lambda points */
+extern size_t
+ekOptimizer_requiredMemory(size_t N, size_t lambda);
+
+
+
+/* Heap memory, in bytes, held by the optimizer, without its distribution */
+extern size_t
+ekOptimizer_memoryUsage(const ekOptimizer* self);
+
+
+
+/* Arena memory, in bytes, used by ekOptimizer_initFromArena */
+extern size_t
+ekOptimizer_arenaSize(size_t N, size_t lambda);
+
+
+
+/* Returns 0, leaving mu and lambda as is, if lambda exceeds the arena population */
+extern int
 ekOptimizer_setMuLambda(ekOptimizer* self, size_t mu, size_t lambda);
 
 
@@ -105,6 +223,66 @@ ekOptimizer_setDistribution(ekOptimizer* self, const ekDistribution* distrib);
 
 
 
+/* Returns 0, keeping the current pool, if the arena has no room for its workers */
+extern int
+ekOptimizer_setThreadPool(ekOptimizer* self, ekThreadPool* pool);
+
+
+
+/* Points found in the cache are not evaluated, NULL disables the cache */
+extern void
+ekOptimizer_setFitnessCache(ekOptimizer* self, ekFitnessCache* cache);
+
+
+
+/* Stops before exceeding maxEvaluations points evaluated, 0 disables it */
+extern void
+ekOptimizer_setEvaluationBudget(ekOptimizer* self, size_t maxEvaluations);
+
+
+
+/* Stops before exceeding a time limit starting now, HUGE_VAL disables it */
+extern void
+ekOptimizer_setDeadline(ekOptimizer* self, double seconds);
+
+
+
+/* Allows lambda to be reduced, down to mu + 1, to fit a budget or deadline */
+extern void
+ekOptimizer_setLambdaShrinking(ekOptimizer* self, int enabled);
+
+
+
+/*
+   Samples each point from its own random stream, so that a run only depends
+   on the seed, whatever the thread pool
+ */
+extern void
+ekOptimizer_setDeterministic(ekOptimizer* self, int enabled);
+
+
+
+/* Records the phases of the iterations in a trace, NULL disables it */
+extern void
+ekOptimizer_setTrace(ekOptimizer* self, ekTrace* trace);
+
+
+
+/*
+   Calls func(data, self, view) at the end of each ekOptimizer_update. Returns
+   0 if an optimizer carved from an arena has no room left for the observer,
+   or if the observers array can't be grown.
+ */
+extern int
+ekOptimizer_addObserver(ekOptimizer* self, ekObserverFunc func, void* data);
+
+
+
+extern void
+ekOptimizer_removeObserver(ekOptimizer* self, ekObserverFunc func, void* data);
+
+
+
 extern void
 ekOptimizer_start(ekOptimizer* self);
 
@@ -115,6 +293,11 @@ ekOptimizer_sampleCloud(ekOptimizer* self);
 
 
 
+extern void
+ekOptimizer_sampleBlocks(ekOptimizer* self, ekMatrix* x, ekMatrix* z, ekSampleBlockFunc func, void* data);
+
+
+
 extern void
 ekOptimizer_samplePoint(ekOptimizer* self, size_t index);
 
@@ -125,6 +308,67 @@ ekOptimizer_evaluateFunction(ekOptimizer* self, double(*function)(const double*,
 
 
 
+/*
+   Returns a copy of the points where column i holds the coordinate i of all
+   the points, so that the points are contiguous for each coordinate. The
+   number of rows is lambda rounded up to a multiple of ESKIT_POINT_LANES, the
+   padding rows repeating the last point. Valid until the next sampling.
+ */
+extern const ekMatrix*
+ekOptimizer_coordinateMajorPoints(ekOptimizer* self);
+
+
+
+/*
+   Sets the fitness of all the points, the fitness i being the one of the
+   point in column i of the population matrix X
+ */
+extern void
+ekOptimizer_setFitnesses(ekOptimizer* self, const double* fitnesses);
+
+
+
+/*
+   Replaces the worst point of the generation by a point from elsewhere, if
+   it is better, between the evaluation and the update. A point whose
+   evaluation was aborted is replaced first. Returns 1 if the point was
+   injected.
+ */
+extern int
+ekOptimizer_injectPoint(ekOptimizer* self, const double* x, double fitness);
+
+
+
+/*
+   Evaluates all the points in a single call, given the coordinate-major
+   points and an array receiving the fitnesses, padded like the points
+ */
+extern void
+ekOptimizer_evaluateBatchFunction(ekOptimizer* self, void(*function)(const ekMatrix*, size_t, double*));
+
+
+
+/*
+   Evaluates the points on the thread pool, the function being thread-safe.
+   The points are scheduled by work stealing, in chunks sized from the
+   average evaluation time. Sequential without a thread pool.
+ */
+extern void
+ekOptimizer_evaluateFunctionParallel(ekOptimizer* self, double(*function)(const double*, size_t));
+
+
+
+/*
+   Evaluates the points in order, passing the mu-th best fitness among the
+   points already evaluated. The function can stop an evaluation as soon as
+   the fitness is known to be above that threshold, then set *aborted and
+   return a lower bound of the fitness.
+ */
+extern void
+ekOptimizer_evaluateFunctionRacing(ekOptimizer* self, double(*function)(const double*, size_t, double, int*));
+
+
+
 extern void
 ekOptimizer_update(ekOptimizer* self);
 
@@ -135,6 +379,18 @@ ekOptimizer_stop(ekOptimizer* self);
 
 
 
+/* Writes the optimizer and distribution states, returns 0 on failure */
+extern int
+ekOptimizer_save(ekOptimizer* self, FILE* file);
+
+
+
+/* Restores a state written by ekOptimizer_save, returns 0 on failure */
+extern int
+ekOptimizer_load(ekOptimizer* self, FILE* file);
+
+
+
 #ifdef __cplusplus
 }
 #endif
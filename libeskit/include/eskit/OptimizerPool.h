@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_OPTIMIZER_POOL_H
+#define ESKIT_OPTIMIZER_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <pthread.h>
+#include <eskit/Optimizer.h>
+#include <eskit/DistributionBuilder.h>
+
+
+
+/*
+   Recycles optimizers, each one with its own point distribution handler made
+   by a builder, to run many short optimizations without paying for their
+   initialization. An optimizer handed out by the pool has the settings of a
+   freshly initialized one, apart from the settings changed directly on its
+   distribution. The pool can be shared by several threads.
+ */
+
+typedef struct s_ekPooledOptimizer {
+	ekOptimizer optim;          /* First member, to get back from an optimizer */
+	ekDistribution distrib;
+	struct s_ekPooledOptimizer* next;
+} ekPooledOptimizer;
+
+
+
+typedef struct {
+	const ekDistributionBuilder* builder;
+	double sigmaInit;
+	double sigmaStop;
+
+	ekRandomizer seededRandomizer;  /* State of a freshly seeded randomizer  */
+
+	pthread_mutex_t mutex;
+	ekPooledOptimizer* freeList;
+	size_t nbFree;
+	size_t nbCreated;
+} ekOptimizerPool;
+
+
+
+#define ekOptimizerPool_nbFree(self) (self)->nbFree
+
+#define ekOptimizerPool_nbCreated(self) (self)->nbCreated
+
+
+
+extern void
+ekOptimizerPool_init(ekOptimizerPool* self, const ekDistributionBuilder* builder, double sigmaInit, double sigmaStop);
+
+
+
+/* All the optimizers should have been released */
+extern void
+ekOptimizerPool_destroy(ekOptimizerPool* self);
+
+
+
+/* Creates count free optimizers for N and lambda */
+extern void
+ekOptimizerPool_reserve(ekOptimizerPool* self, size_t N, size_t lambda, size_t count);
+
+
+
+/*
+   Returns an optimizer of dimension N, with mu set to lambda / 2, recycling a
+   free one with enough room for lambda points if possible
+ */
+extern ekOptimizer*
+ekOptimizerPool_acquire(ekOptimizerPool* self, size_t N, size_t lambda);
+
+
+
+extern void
+ekOptimizerPool_release(ekOptimizerPool* self, ekOptimizer* optim);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_OPTIMIZER_POOL_H */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_PROCESS_FARM_H
+#define ESKIT_PROCESS_FARM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <eskit/Types.h>
+#include <eskit/Doorbell.h>
+
+
+
+/*
+   Implements a farm of worker processes evaluating a fitness function, for
+   functions which can't run on threads, such as simulators with a global
+   state. The workers are forked once, then each one evaluates a point at a
+   time, the points and the fitnesses being passed through a shared memory
+   segment and the processes signaled with doorbells.
+
+   A worker which dies is respawned, and the point it was evaluating is
+   evaluated again. If the respawn fails, it is retried at the next health
+   check, the other workers taking the points meanwhile. A point which killed ESKIT_PROCESS_FARM_MAX_CRASHES
+   workers gets a HUGE_VAL fitness.
+ */
+
+#define ESKIT_PROCESS_FARM_MAX_CRASHES 3
+
+
+
+struct s_ekProcessFarmSlot;
+
+
+
+typedef struct {
+	size_t N;
+	size_t nbWorkers;
+	double(*function)(const double*, size_t);
+
+	void* shared;                       /* Shared memory segment            */
+	size_t sharedSize;
+	ekDoorbell* doneBell;               /* Rung by the workers              */
+	struct s_ekProcessFarmSlot* slots;  /* One per worker, in the segment   */
+	pid_t* pids;
+
+	size_t* pending;                    /* Points left to evaluate          */
+	unsigned char* nbCrashes;           /* Per point of the current batch   */
+	size_t capacity;
+
+	size_t nbRespawns;
+} ekProcessFarm;
+
+
+
+#define ekProcessFarm_nbWorkers(self) (self)->nbWorkers
+
+#define ekProcessFarm_nbRespawns(self) (self)->nbRespawns
+
+
+
+/*
+   Forks nbWorkers processes evaluating function in dimension N. Better done
+   before creating any thread, a forked process only having the calling one.
+   Returns 0, with nothing left to destroy, if the shared memory segment can't
+   be mapped or a worker can't be forked.
+ */
+extern int
+ekProcessFarm_init(ekProcessFarm* self, size_t N, size_t nbWorkers, double(*function)(const double*, size_t));
+
+
+
+/* Stops and waits for the workers */
+extern void
+ekProcessFarm_destroy(ekProcessFarm* self);
+
+
+
+/* Evaluates the points of the optimizer on the workers, returns when done */
+extern void
+ekProcessFarm_evaluate(ekProcessFarm* self, ekOptimizer* optim);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_PROCESS_FARM_H */
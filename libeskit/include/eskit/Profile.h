@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_PROFILE_H
+#define ESKIT_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <eskit/Clock.h>
+
+
+
+/*
+   Time spent in, and number of calls to, each phase of the iterations. The
+   distribution update phase includes the eigen solver phase.
+
+   Building with ESKIT_DISABLE_PROFILING defined removes the measures, the
+   counters then stay at 0.
+ */
+
+enum ekProfilePhase {
+	ekProfilePhase_Sample = 0,
+	ekProfilePhase_Evaluate,
+	ekProfilePhase_Sort,
+	ekProfilePhase_DistributionUpdate,
+	ekProfilePhase_EigenSolve,
+	ekProfilePhase_Stop,
+	ekProfilePhase_Count
+};
+
+
+
+typedef struct {
+	double time[ekProfilePhase_Count];       /* Seconds spent in each phase */
+	size_t nbCalls[ekProfilePhase_Count];
+	double start[ekProfilePhase_Count];
+} ekProfile;
+
+
+
+#ifdef ESKIT_DISABLE_PROFILING
+	#define ekProfile_begin(self, phase) ((void)0)
+	#define ekProfile_end(self, phase) ((void)0)
+#else
+	#define ekProfile_begin(self, phase) (self)->start[(phase)] = ekClock_now()
+	#define ekProfile_end(self, phase) \
+		((self)->time[(phase)] += ekClock_now() - (self)->start[(phase)], (self)->nbCalls[(phase)] += 1)
+#endif
+
+
+
+extern void
+ekProfile_reset(ekProfile* self);
+
+
+
+extern const char*
+ekProfilePhaseString(enum ekProfilePhase phase);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_PROFILE_H */
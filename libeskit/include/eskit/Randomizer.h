@@ -14,7 +14,9 @@ extern "C" {
 
 
 
+#include <stddef.h>
 #include <stdint.h>
+#include <eskit/Arena.h>
 
 
 
@@ -47,11 +49,34 @@ ekRandomizer_init(ekRandomizer* self, enum ekRandomizerSize size);
 
 
 
+/* The arena should have at least ekRandomizer_arenaSize bytes left */
+extern void
+ekRandomizer_initFromArena(ekRandomizer* self, enum ekRandomizerSize size, ekArena* arena);
+
+
+
 extern void
 ekRandomizer_destroy(ekRandomizer* self);
 
 
 
+/* Heap memory, in bytes, allocated by ekRandomizer_init */
+extern size_t
+ekRandomizer_requiredMemory(enum ekRandomizerSize size);
+
+
+
+extern size_t
+ekRandomizer_memoryUsage(const ekRandomizer* self);
+
+
+
+/* Arena memory, in bytes, used by ekRandomizer_initFromArena */
+extern size_t
+ekRandomizer_arenaSize(enum ekRandomizerSize size);
+
+
+
 extern void
 ekRandomizer_copy(ekRandomizer* self, const ekRandomizer* rnd);
 
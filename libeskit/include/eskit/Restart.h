@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_RESTART_H
+#define ESKIT_RESTART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <pthread.h>
+#include <eskit/Randomizer.h>
+#include <eskit/ThreadPool.h>
+#include <eskit/DistributionBuilder.h>
+
+
+
+/*
+   Implements a restart driver : independent optimizations are run one after
+   the other, until an evaluation budget is exhausted or a target fitness is
+   reached.
+
+   With IPOP, the population size is doubled at each restart. With BIPOP, the
+   restarts alternate between that large population regime and a small
+   population regime, with random population size and step length, so that
+   both regimes get a similar share of the evaluations.
+
+   When a thread pool is set, each worker of the pool runs restarts with its
+   own optimizer and distribution. The workers only share the best point found
+   so far and the evaluation budget, each worker doubling its own population
+   size.
+
+   The full algorithms are described in :
+   A Restart CMA Evolution Strategy With Increasing Population Size
+   Anne Auger & Nikolaus Hansen
+   Benchmarking a BI-Population CMA-ES on the BBOB-2009 Function Testbed
+   Nikolaus Hansen
+ */
+
+enum ekRestartStrategy {
+	ekRestartStrategy_IPOP = 0,
+	ekRestartStrategy_BIPOP
+};
+
+
+
+typedef struct {
+	size_t N;
+	enum ekRestartStrategy strategy;
+	const ekDistributionBuilder* builder;
+
+	double sigmaInit;
+	double sigmaStop;
+	size_t lambdaInit;
+	double* xMeanInit;
+	double* lowerBound;   /* If set, initial means are drawn in the bounds     */
+	double* upperBound;
+
+	size_t maxEvaluations;
+	double targetFitness;
+
+	ekThreadPool* threadPool;
+	ekRandomizer randomizer;
+
+	/* State shared by the workers */
+	pthread_mutex_t mutex;
+	int done;
+	size_t nbEvaluations;
+	size_t nbRestarts;
+	size_t nbLargeRestarts;   /* Of all the workers, each one doubling its own   */
+	size_t largeEvaluations;  /* Evaluations spent in each BIPOP regime        */
+	size_t smallEvaluations;
+	double* bestX;
+	double bestFitness;
+} ekRestart;
+
+
+
+#define ekRestart_xMeanInit(self) (self)->xMeanInit
+
+#define ekRestart_getRandomizer(self) &((self)->randomizer)
+
+#define ekRestart_nbEvaluations(self) (self)->nbEvaluations
+
+#define ekRestart_nbRestarts(self) (self)->nbRestarts
+
+#define ekRestart_bestX(self) (self)->bestX
+
+#define ekRestart_bestFitness(self) (self)->bestFitness
+
+
+
+extern void
+ekRestart_init(ekRestart* self, size_t N, const ekDistributionBuilder* builder);
+
+
+
+extern void
+ekRestart_destroy(ekRestart* self);
+
+
+
+extern void
+ekRestart_setStrategy(ekRestart* self, enum ekRestartStrategy strategy);
+
+
+
+extern void
+ekRestart_setSigma(ekRestart* self, double sigmaInit, double sigmaStop);
+
+
+
+/* Initial population size, the default is the optimizer default */
+extern void
+ekRestart_setLambda(ekRestart* self, size_t lambda);
+
+
+
+/* Each restart starts from a point uniformly drawn in [lower, upper] */
+extern void
+ekRestart_setBounds(ekRestart* self, const double* lower, const double* upper);
+
+
+
+extern void
+ekRestart_setBudget(ekRestart* self, size_t maxEvaluations);
+
+
+
+extern void
+ekRestart_setTargetFitness(ekRestart* self, double targetFitness);
+
+
+
+extern void
+ekRestart_setThreadPool(ekRestart* self, ekThreadPool* pool);
+
+
+
+/* The function should be thread-safe if a thread pool is set */
+extern void
+ekRestart_run(ekRestart* self, double(*function)(const double*, size_t));
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_RESTART_H */
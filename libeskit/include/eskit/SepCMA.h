@@ -45,6 +45,8 @@ typedef struct {
 	double* D;
 
 	double* tmpVector;  /* Intermediate results storage                        */
+
+	ekArena* arena;     /* NULL if the state is on the heap                    */
 } ekSepCMA;
 
 
@@ -59,11 +61,37 @@ ekSepCMA_init(ekSepCMA* self, size_t N);
 
 
 
+/*
+   Carves all the state from the arena, which destroying the instance leaves
+   alone. Returns 0 if the arena has less than ekSepCMA_arenaSize bytes left.
+ */
+extern int
+ekSepCMA_initFromArena(ekSepCMA* self, size_t N, ekArena* arena);
+
+
+
 extern void
 ekSepCMA_destroy(ekSepCMA* self);
 
 
 
+/* Heap memory, in bytes, allocated by ekSepCMA_init */
+extern size_t
+ekSepCMA_requiredMemory(size_t N);
+
+
+
+extern size_t
+ekSepCMA_memoryUsage(const ekSepCMA* self);
+
+
+
+/* Arena memory, in bytes, used by ekSepCMA_initFromArena */
+extern size_t
+ekSepCMA_arenaSize(size_t N);
+
+
+
 extern void
 ekSepCMA_setSigma(ekSepCMA* self, double sigmaInit, double sigmaStop);
 
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_SERVER_H
+#define ESKIT_SERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <eskit/ThreadPool.h>
+#include <eskit/StopCriterionId.h>
+
+
+
+/*
+   Implements an optimization server : clients connected through TCP or Unix
+   sockets open optimization sessions, each one with its own dimension,
+   population size and kind of point distribution, and drive them with ask
+   and tell messages, the evaluation of the points staying on the client
+   side. The optimizers of the sessions come from optimizer pools, and are
+   recycled when the sessions are closed.
+
+   The server handles the messages of all the clients in a single thread.
+   The sessions to sample or to update are gathered, then stepped together
+   on a thread pool, so that many small sessions make one batch.
+
+   The messages use the encoding of ekSocket. The points are sent as lambda
+   points of N doubles, the fitnesses in the same order.
+
+     Hello  (0, magic, version, maxN)         sent by both sides on
+                                              connection, the client
+                                              sending maxN = 0
+     Open   (1, N, lambda, distribution)      followed by sigmaInit,
+                                              sigmaStop, the seed and the
+                                              N doubles of xMeanInit
+     Ask    (2, session, 0, 0)
+     Tell   (3, session, lambda, 0)           followed by lambda fitnesses
+     Close  (4, session, 0, 0)
+     Opened (5, session, lambda, 0)
+     Points (6, session, stop, count)         followed by the best fitness,
+                                              the best point, and the count
+                                              points of the generation, none
+                                              once the session is stopped
+     Closed (7, session, 0, 0)
+     Error  (8, error, session, 0)
+
+   A lambda of 0 opens a session with the default population size. An Open
+   with N above maxN, or a Tell with a wrong number of fitnesses, closes the
+   connection. Asking again returns the same points until the next tell.
+   Each client sees the replies in the order of its requests, and the
+   sessions of a client are closed when it disconnects.
+ */
+
+#define ESKIT_SERVER_MAGIC 0x534b5345 /* "ESKS" */
+
+#define ESKIT_SERVER_VERSION 1
+
+
+
+enum ekServerDistribution {
+	ekServerDistribution_CSA = 0,
+	ekServerDistribution_CMA,
+	ekServerDistribution_SepCMA
+};
+
+
+
+enum ekServerError {
+	ekServerError_UnknownSession = 1,
+	ekServerError_TooManySessions,
+	ekServerError_BadParameters,
+	ekServerError_BadState               /* Tell without points to evaluate */
+};
+
+
+
+struct s_ekServerLink;
+
+struct s_ekServerSession;
+
+struct s_ekServerPool;
+
+struct s_ekServerJob;
+
+struct pollfd;
+
+
+
+typedef struct {
+	int listenFd;
+	char* unixPath;                      /* Removed on destroy, NULL for TCP */
+	ekThreadPool* threadPool;
+
+	size_t maxSessions;
+	size_t maxN;
+	size_t maxLambda;
+
+	struct s_ekServerLink* links;
+	size_t nbLinks;
+	size_t linksCapacity;
+	uint32_t nextLinkId;
+	struct pollfd* fds;                  /* One more than linksCapacity      */
+
+	struct s_ekServerSession* sessions;
+	size_t sessionsCapacity;
+	uint32_t* freeSessions;              /* Free session slots, as a stack   */
+	size_t nbFreeSessions;
+
+	struct s_ekServerPool** pools;       /* One per distribution and sigmas  */
+	size_t nbPools;
+
+	struct s_ekServerJob* jobs;          /* Requests handled by the batch    */
+	size_t nbJobs;
+	size_t jobsCapacity;
+	size_t iteration;
+	int backlog;                         /* Requests left for the next batch */
+	double* fitnesses;                   /* Decoded fitnesses of a tell      */
+
+	size_t nbSessions;
+	size_t nbSteps;
+	size_t nbBatches;
+} ekServer;
+
+
+
+#define ekServer_nbLinks(self) (self)->nbLinks
+
+#define ekServer_nbSessions(self) (self)->nbSessions
+
+#define ekServer_nbSteps(self) (self)->nbSteps
+
+#define ekServer_nbBatches(self) (self)->nbBatches
+
+
+
+/* Listens on address, see ekSocket. Returns 0 on failure. */
+extern int
+ekServer_init(ekServer* self, const char* address);
+
+
+
+/* Closes all the sessions and all the connections */
+extern void
+ekServer_destroy(ekServer* self);
+
+
+
+/* The sessions are stepped on the thread pool, NULL steps them in the caller */
+extern void
+ekServer_setThreadPool(ekServer* self, ekThreadPool* pool);
+
+
+
+/*
+   Bounds the number of sessions, their dimension and their population
+   size. The defaults are 65536 sessions, N up to 1024 and lambda up to 1024.
+   Should be set before the first connection.
+ */
+extern void
+ekServer_setLimits(ekServer* self, size_t maxSessions, size_t maxN, size_t maxLambda);
+
+
+
+/*
+   Waits up to timeout seconds, HUGE_VAL to wait forever, for messages, then
+   handles all of them with a single batch of steps. Returns 0 if nothing
+   happened.
+ */
+extern int
+ekServer_poll(ekServer* self, double timeout);
+
+
+
+/* --- Client -------------------------------------------------------------- */
+
+typedef struct {
+	int fd;
+	size_t maxN;
+	unsigned char* buffer;
+	size_t capacity;
+} ekServerClient;
+
+
+
+typedef struct {
+	ekServerClient* client;
+	uint32_t id;
+	size_t N;
+	size_t lambda;
+	int sampled;                         /* Points hold the generation to tell */
+	enum ekStopCriterionId stop;
+	double bestFitness;
+	double* bestX;
+	double* points;
+	enum ekServerError error;            /* Last error sent by the server    */
+} ekServerSession;
+
+
+
+#define ekServerSession_N(self) (self)->N
+
+#define ekServerSession_lambda(self) (self)->lambda
+
+#define ekServerSession_stop(self) (self)->stop
+
+#define ekServerSession_bestFitness(self) (self)->bestFitness
+
+#define ekServerSession_bestX(self) (self)->bestX
+
+#define ekServerSession_error(self) (self)->error
+
+
+
+/* Connects to a server, returns 0 on failure */
+extern int
+ekServerClient_connect(ekServerClient* self, const char* address);
+
+
+
+/* The sessions of the client should be closed first */
+extern void
+ekServerClient_disconnect(ekServerClient* self);
+
+
+
+/*
+   Opens a session on the server. xMeanInit can be NULL to start from the
+   origin. Returns 0 on failure, the session being then left unopened.
+ */
+extern int
+ekServerSession_open(ekServerSession* self, ekServerClient* client, enum ekServerDistribution distribution, size_t N, size_t lambda, double sigmaInit, double sigmaStop, uint32_t seed, const double* xMeanInit);
+
+
+
+/*
+   Returns the lambda points of the generation, point i starting at i * N.
+   Returns NULL on failure, or once the session is stopped.
+ */
+extern const double*
+ekServerSession_ask(ekServerSession* self);
+
+
+
+/*
+   Sends the fitnesses of the points, and receives the points of the next
+   generation, returned by the next ask. Returns 0 on failure.
+ */
+extern int
+ekServerSession_tell(ekServerSession* self, const double* fitnesses);
+
+
+
+extern void
+ekServerSession_close(ekServerSession* self);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_SERVER_H */
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_SHARED_CHANNEL_H
+#define ESKIT_SHARED_CHANNEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <eskit/Types.h>
+#include <eskit/Arena.h>
+#include <eskit/Doorbell.h>
+
+
+
+/*
+   Implements an ask/tell channel with an evaluator running in another
+   process, through a named POSIX shared memory segment. The optimizer state,
+   including the points, is carved from the segment : the evaluator reads the
+   points and writes the fitnesses in place, without any copy.
+
+   The segment starts with a header, followed by the fitnesses array and the
+   optimizer state. The points are lambdaMax arrays of N doubles, one after
+   the other, at xOffset bytes from the start of the segment. A generation is
+   ready to be evaluated when the generation counter changes, the fitnesses
+   are ready when fitnessGeneration is set to the generation counter. Both
+   changes are signaled by a doorbell, evaluators not linked to ESKit can
+   poll the counters instead.
+ */
+
+#define ESKIT_SHARED_CHANNEL_MAGIC 0x434b5345 /* "ESKC" */
+
+
+
+typedef struct {
+	uint32_t magic;
+	uint32_t closed;             /* Set when the optimizer side is done      */
+	uint64_t N;
+	uint64_t lambdaMax;
+	uint64_t lambda;             /* Number of points of the generation       */
+	uint64_t generation;         /* Incremented when the points are ready    */
+	uint64_t fitnessGeneration;  /* Set to generation when fitnesses ready   */
+	uint64_t xOffset;            /* Points, in bytes from the segment start  */
+	uint64_t fitnessOffset;      /* Fitnesses, in bytes from the start       */
+	ekDoorbell askBell;          /* Rung when the points are ready           */
+	ekDoorbell tellBell;         /* Rung when the fitnesses are ready        */
+} ekSharedChannelHeader;
+
+
+
+typedef struct {
+	char* name;
+	int owner;                   /* Set on the side which created the segment */
+	void* shared;
+	size_t sharedSize;
+	ekSharedChannelHeader* header;
+	double* fitnesses;
+	ekArena arena;               /* The optimizer state, on the owner side    */
+	uint64_t generation;         /* Last generation asked, evaluator side     */
+} ekSharedChannel;
+
+
+
+#define ekSharedChannel_N(self) (self)->header->N
+
+#define ekSharedChannel_point(self, index) ((const double*)((char*)(self)->shared + (self)->header->xOffset) + (index) * (self)->header->N)
+
+#define ekSharedChannel_fitnesses(self) (self)->fitnesses
+
+
+
+/*
+   Creates the segment, for an optimizer of dimension N with up to lambdaMax
+   points. The name should start with a '/'. Returns 0 on failure.
+ */
+extern int
+ekSharedChannel_create(ekSharedChannel* self, const char* name, size_t N, size_t lambdaMax);
+
+
+
+/* Opens a segment created by another process, returns 0 on failure */
+extern int
+ekSharedChannel_open(ekSharedChannel* self, const char* name);
+
+
+
+/* Unmaps the segment. On the creator side, closes the channel and removes the segment */
+extern void
+ekSharedChannel_destroy(ekSharedChannel* self);
+
+
+
+/*
+   Initializes an optimizer whose state, including the points, is in the
+   segment. Returns 0 if the segment already holds an optimizer.
+ */
+extern int
+ekSharedChannel_initOptimizer(ekSharedChannel* self, ekOptimizer* optim);
+
+
+
+/*
+   Publishes the points of the optimizer and waits for their fitnesses, for
+   at most timeout seconds. Returns 0 on timeout.
+ */
+extern int
+ekSharedChannel_evaluate(ekSharedChannel* self, ekOptimizer* optim, double timeout);
+
+
+
+/*
+   Evaluator side : waits for a new generation for at most timeout seconds,
+   returns its number of points, 0 on timeout or when the channel is closed
+ */
+extern size_t
+ekSharedChannel_ask(ekSharedChannel* self, double timeout);
+
+
+
+/* Evaluator side : signals that the fitnesses of the generation are written */
+extern void
+ekSharedChannel_tell(ekSharedChannel* self);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_SHARED_CHANNEL_H */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_SOCKET_H
+#define ESKIT_SOCKET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+
+/*
+   Socket helpers shared by the remote evaluation and the optimization
+   server. An address is either "unix:PATH" or "HOST:PORT", an empty HOST or
+   "*" listening on all the interfaces.
+
+   The messages of both protocols start with a header of four little endian
+   32 bits integers (type, a, b, c), and carry little endian IEEE 754 doubles.
+ */
+
+#define ESKIT_SOCKET_HEADER_SIZE 16
+
+
+
+/* Bytes waiting to be sent, or received and not handled yet */
+typedef struct {
+	unsigned char* data;
+	size_t begin, end, capacity;
+} ekSocketBuffer;
+
+
+
+#define ekSocketBuffer_size(self) ((self)->end - (self)->begin)
+
+#define ekSocketBuffer_front(self) ((self)->data + (self)->begin)
+
+
+
+extern void
+ekSocketBuffer_init(ekSocketBuffer* self);
+
+
+
+extern void
+ekSocketBuffer_destroy(ekSocketBuffer* self);
+
+
+
+/* Returns room for size more bytes at the end of the buffer */
+extern unsigned char*
+ekSocketBuffer_reserve(ekSocketBuffer* self, size_t size);
+
+
+
+extern void
+ekSocket_putU32(unsigned char* p, uint32_t value);
+
+
+
+extern uint32_t
+ekSocket_getU32(const unsigned char* p);
+
+
+
+extern void
+ekSocket_putF64(unsigned char* p, double value);
+
+
+
+extern double
+ekSocket_getF64(const unsigned char* p);
+
+
+
+extern void
+ekSocket_putHeader(unsigned char* p, uint32_t type, uint32_t a, uint32_t b, uint32_t c);
+
+
+
+/*
+   Returns a non-blocking socket listening on address, or -1. For a Unix
+   socket, a stale socket file is removed, and the path to remove once done
+   is returned in unixPath, which is set to NULL otherwise.
+ */
+extern int
+ekSocket_listen(const char* address, char** unixPath);
+
+
+
+/* Returns a non-blocking connection from a listening socket, or -1 */
+extern int
+ekSocket_accept(int listenFd);
+
+
+
+/* Returns a blocking connection to address, or -1 */
+extern int
+ekSocket_connect(const char* address);
+
+
+
+/* Writes the whole data on a blocking socket, returns 0 on failure */
+extern int
+ekSocket_sendAll(int fd, const unsigned char* data, size_t size);
+
+
+
+/* Reads exactly size bytes from a blocking socket, returns 0 on failure */
+extern int
+ekSocket_recvAll(int fd, unsigned char* data, size_t size);
+
+
+
+/* Sends as much as possible without blocking, returns 0 if the link is lost */
+extern int
+ekSocket_flush(int fd, ekSocketBuffer* buffer);
+
+
+
+/* Reads all the available bytes, returns 0 if the link is lost */
+extern int
+ekSocket_read(int fd, ekSocketBuffer* buffer);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_SOCKET_H */
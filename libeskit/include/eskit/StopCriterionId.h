@@ -22,7 +22,9 @@ enum ekStopCriterionId {
 	ekStopCriterionId_NoEffectCoord,
 	ekStopCriterionId_ConditionCov,
 	ekStopCriterionId_EigenSolverFailure,
-	ekStopCriterionId_BestFitnessStall
+	ekStopCriterionId_BestFitnessStall,
+	ekStopCriterionId_EvaluationBudget,
+	ekStopCriterionId_Deadline
 };
 
 
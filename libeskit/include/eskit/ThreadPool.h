@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_THREAD_POOL_H
+#define ESKIT_THREAD_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stddef.h>
+#include <pthread.h>
+
+
+
+/*
+   Implements a fixed size pool of worker threads, running "parallel for" jobs.
+
+   A job is a set of tasks, identified by an index in the [0, nbTasks - 1]
+   range. The thread calling ekThreadPool_run takes part in the job as the
+   worker 0, the other workers being numbered from 1 to nbThreads - 1. A pool
+   runs one job at a time, it should not be shared by concurrent callers.
+ */
+
+typedef void(*ekThreadPoolTask)(void* data, size_t taskId, size_t workerId);
+
+
+
+/* Processes the items [begin, end[ of a range job */
+typedef void(*ekThreadPoolRangeTask)(void* data, size_t begin, size_t end, size_t workerId);
+
+
+
+struct s_ekThreadPoolWorker;
+
+
+
+typedef struct {
+	size_t nbThreads;           /* Number of workers, including the caller     */
+	struct s_ekThreadPoolWorker* workers;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t jobCond;     /* Signaled when a job is submitted            */
+	pthread_cond_t doneCond;    /* Signaled when the last task is done         */
+
+	ekThreadPoolTask task;
+	void* data;
+	size_t nbTasks;
+	size_t nextTask;
+	size_t nbTasksDone;
+	size_t jobId;
+
+	int shutdown;
+} ekThreadPool;
+
+
+
+#define ekThreadPool_nbThreads(self) (self)->nbThreads
+
+
+
+extern void
+ekThreadPool_init(ekThreadPool* self, size_t nbThreads);
+
+
+
+extern void
+ekThreadPool_destroy(ekThreadPool* self);
+
+
+
+/* Runs task(data, i, workerId) for i in [0, nbTasks - 1], returns when done */
+extern void
+ekThreadPool_run(ekThreadPool* self, ekThreadPoolTask task, void* data, size_t nbTasks);
+
+
+
+/*
+   Runs task(data, begin, end, workerId) on chunks of at most chunkSize items
+   covering [0, nbItems - 1], returns when done. Each worker starts with an
+   equal share of the items, then steals half of the items left to another
+   worker once its own share is done, so that uneven item costs are balanced.
+ */
+extern void
+ekThreadPool_runRange(ekThreadPool* self, ekThreadPoolRangeTask task, void* data, size_t nbItems, size_t chunkSize);
+
+
+
+/* Returns 1 if the calling thread is running a task of any pool */
+extern int
+ekThreadPool_inTask(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_THREAD_POOL_H */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#ifndef ESKIT_TRACE_H
+#define ESKIT_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <eskit/Profile.h>
+
+
+
+/*
+   Records the begin and end times of the iteration phases, in a buffer
+   allocated once. Any thread can record events without locking; once the
+   buffer is full, further events are dropped. The events can be written in
+   the Chrome trace event format, which can be read by chrome://tracing or
+   Perfetto.
+ */
+
+typedef struct {
+	double time;         /* Seconds since the trace origin              */
+	int64_t arg;         /* Point or block index, -1 if none            */
+	uint32_t threadId;   /* Small integer, given to each thread in turn */
+	uint16_t phase;
+	char type;           /* 'B' for begin, 'E' for end                  */
+} ekTraceEvent;
+
+
+
+typedef struct {
+	ekTraceEvent* events;
+	size_t capacity;
+	size_t nbEventsRequested;  /* Incremented atomically, can exceed capacity */
+	double origin;
+} ekTrace;
+
+
+
+#define ekTrace_nbEvents(self) (((self)->nbEventsRequested < (self)->capacity) ? (self)->nbEventsRequested : (self)->capacity)
+
+#define ekTrace_nbDropped(self) ((self)->nbEventsRequested - ekTrace_nbEvents(self))
+
+
+
+extern void
+ekTrace_init(ekTrace* self, size_t capacity);
+
+
+
+extern void
+ekTrace_destroy(ekTrace* self);
+
+
+
+/* Removes all the events, and restarts the time origin */
+extern void
+ekTrace_clear(ekTrace* self);
+
+
+
+extern void
+ekTrace_begin(ekTrace* self, enum ekProfilePhase phase, int64_t arg);
+
+
+
+extern void
+ekTrace_end(ekTrace* self, enum ekProfilePhase phase, int64_t arg);
+
+
+
+/* Writes the events as Chrome trace JSON, returns 0 on failure */
+extern int
+ekTrace_dump(const ekTrace* self, FILE* file);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESKIT_TRACE_H */
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "eskit/Macros.h"
+#include "eskit/Optimizer.h"
+#include "eskit/Archive.h"
+
+
+
+/* Records of a new archive, when no capacity is given */
+#define ekArchive_defaultCapacity 1024
+
+
+
+#define ekArchive_fileSize(N, capacity) (ESKIT_ARCHIVE_HEADER_SIZE + (capacity) * ((N) + 2) * sizeof(double))
+
+
+
+/* Maps size bytes of the file, the archive being left untouched on failure */
+static int
+ekArchive_map(ekArchive* self, size_t size) {
+	void* data;
+
+	data = mmap(NULL, size, self->writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, self->fd, 0);
+	if (data == MAP_FAILED)
+		return 0;
+
+	self->data = data;
+	self->size = size;
+	self->header = (ekArchiveHeader*)self->data;
+	self->records = (double*)((char*)self->data + ESKIT_ARCHIVE_HEADER_SIZE);
+	return 1;
+}
+
+
+
+int
+ekArchive_create(ekArchive* self, const char* path, size_t N, size_t capacity) {
+	if (capacity == 0)
+		capacity = ekArchive_defaultCapacity;
+
+	self->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (self->fd < 0)
+		return 0;
+
+	self->writable = 1;
+	self->failed = 0;
+	self->N = N;
+	self->capacity = capacity;
+
+	if ((posix_fallocate(self->fd, 0, ekArchive_fileSize(N, capacity)) != 0) || (!ekArchive_map(self, ekArchive_fileSize(N, capacity)))) {
+		close(self->fd);
+		return 0;
+	}
+
+	memset(self->header, 0, ESKIT_ARCHIVE_HEADER_SIZE);
+	self->header->magic = ESKIT_ARCHIVE_MAGIC;
+	self->header->version = ESKIT_ARCHIVE_VERSION;
+	self->header->N = N;
+	self->header->nbRecords = 0;
+
+	return 1;
+}
+
+
+
+int
+ekArchive_open(ekArchive* self, const char* path) {
+	struct stat info;
+	ekArchiveHeader header;
+
+	self->fd = open(path, O_RDONLY);
+	if (self->fd < 0)
+		return 0;
+
+	self->writable = 0;
+	self->failed = 0;
+
+	/* Check the header before mapping the whole file */
+	if ((read(self->fd, &header, sizeof(header)) != sizeof(header)) ||
+	    (header.magic != ESKIT_ARCHIVE_MAGIC) ||
+	    (header.version != ESKIT_ARCHIVE_VERSION) ||
+	    (fstat(self->fd, &info) != 0) ||
+	    ((size_t)info.st_size < ekArchive_fileSize(header.N, header.nbRecords)) ||
+	    (!ekArchive_map(self, info.st_size))) {
+		close(self->fd);
+		return 0;
+	}
+
+	self->N = header.N;
+	self->capacity = header.nbRecords;
+
+	return 1;
+}
+
+
+
+void
+ekArchive_close(ekArchive* self) {
+	size_t size;
+
+	size = ekArchive_fileSize(self->N, ekArchive_nbRecords(self));
+
+	munmap(self->data, self->size);
+	if (self->writable)
+		(void)ftruncate(self->fd, size);
+	close(self->fd);
+}
+
+
+
+/* Doubles the room of the file until nbRecords fit */
+static int
+ekArchive_reserve(ekArchive* self, size_t nbRecords) {
+	size_t capacity, oldSize;
+	void* oldData;
+
+	if (nbRecords <= self->capacity)
+		return 1;
+
+	for(capacity = 2 * self->capacity; capacity < nbRecords; capacity *= 2);
+
+	/* Allocated blocks, so that a full disk is an error rather than a SIGBUS */
+	if (posix_fallocate(self->fd, 0, ekArchive_fileSize(self->N, capacity)) != 0)
+		return 0;
+
+	/* The old mapping is kept until the new one is in place */
+	oldData = self->data;
+	oldSize = self->size;
+	if (!ekArchive_map(self, ekArchive_fileSize(self->N, capacity)))
+		return 0;
+	munmap(oldData, oldSize);
+
+	self->capacity = capacity;
+	return 1;
+}
+
+
+
+static int
+ekArchive_appendGeneration(ekArchive* self, const ekOptimizer* optim, size_t generation) {
+	size_t i, lambda, nbRecords;
+	double* record;
+	const ekPoint* point;
+
+	lambda = ekOptimizer_lambda(optim);
+	nbRecords = ekArchive_nbRecords(self);
+	if (!ekArchive_reserve(self, nbRecords + lambda)) {
+		self->failed = 1;
+		return 0;
+	}
+
+	record = self->records + nbRecords * (self->N + 2);
+	point = optim->pointArray;
+	for(i = 0; i < lambda; ++i, ++point, record += self->N + 2) {
+		record[0] = (double)generation;
+		record[1] = point->fitness;
+		memcpy(record + 2, point->x, self->N * sizeof(double));
+	}
+
+	/* The records are complete before being counted */
+	self->header->nbRecords = nbRecords + lambda;
+
+	return 1;
+}
+
+
+
+int
+ekArchive_append(ekArchive* self, const ekOptimizer* optim) {
+	return ekArchive_appendGeneration(self, optim, ekOptimizer_nbUpdates(optim));
+}
+
+
+
+void
+ekArchive_observe(void* data, const ekOptimizer* optim, const ekGenerationView* view) {
+	/* Called after the update, which counted the generation */
+	ekArchive_appendGeneration((ekArchive*)data, optim, view->nbUpdates - 1);
+}
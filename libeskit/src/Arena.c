@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "eskit/Arena.h"
+
+
+
+void
+ekArena_init(ekArena* self, void* memory, size_t size) {
+	size_t padding;
+
+	/* Start on an aligned address */
+	padding = (ESKIT_ARENA_ALIGNMENT - ((uintptr_t)memory % ESKIT_ARENA_ALIGNMENT)) % ESKIT_ARENA_ALIGNMENT;
+	if (padding > size)
+		padding = size;
+
+	self->memory = ((char*)memory) + padding;
+	self->size = size - padding;
+	self->used = 0;
+}
+
+
+
+void*
+ekArena_alloc(ekArena* self, size_t size) {
+	void* ret;
+
+	if (self == NULL)
+		return malloc(size);
+
+	size = ekArena_alignedSize(size);
+	if (size > self->size - self->used)
+		return NULL;
+
+	ret = self->memory + self->used;
+	self->used += size;
+
+	return ret;
+}
+
+
+
+void
+ekArena_reset(ekArena* self) {
+	self->used = 0;
+}
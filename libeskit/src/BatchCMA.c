@@ -0,0 +1,792 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "eskit/Macros.h"
+#include "eskit/ArrayOps.h"
+#include "eskit/BatchCMA.h"
+#include "eskit/MeanWeights.h"
+
+
+
+/* Offsets of the element i of a vector, (col, row) of a matrix, (j, i) of a population */
+#define ekBatchCMA_vec(self, i) ((i) * (self)->stride)
+
+#define ekBatchCMA_mat(self, col, row) (((col) * (self)->N + (row)) * (self)->stride)
+
+#define ekBatchCMA_pop(self, j, i) (((j) * (self)->N + (i)) * (self)->stride)
+
+/*
+   Loops over the instances by blocks of a fixed number of lanes : with a
+   known trip count and restrict pointers, the compiler vectorizes the inner
+   loop without runtime checks.
+ */
+#define ekBatchCMA_lanes 4
+
+#define ekBatchCMA_forEach(b, l, n) for(b = 0; b < (n); b += ekBatchCMA_lanes) for(l = 0; l < ekBatchCMA_lanes; ++l)
+
+/*
+   Jacobi sweeps stop when the squared off-diagonal part is that small,
+   relatively, and skip the pairs already that small
+ */
+#define ekBatchCMA_jacobiTolerance 1e-20
+
+#define ekBatchCMA_jacobiMaxSweeps 32
+
+/* Largest dimension decomposed by the batched Jacobi */
+#define ekBatchCMA_jacobiMaxN 8
+
+
+
+int
+ekBatchCMA_init(ekBatchCMA* self, size_t K, size_t N, size_t lambda) {
+	size_t S;
+	double sum;
+
+	if ((N == 0) || (N > ESKIT_BATCH_CMA_MAX_N))
+		return 0;
+
+	self->K = K;
+	self->stride = S = ((K + ekBatchCMA_lanes - 1) / ekBatchCMA_lanes) * ekBatchCMA_lanes;
+	self->N = N;
+	self->mu = lambda / 2;
+	self->lambda = lambda;
+
+	/* Same weights and constants as an optimizer with the default settings */
+	self->weights = newArray(double, self->mu);
+	ekLog_MeanWeightsGenerator.generate(self->weights, self->mu);
+	sum = ekArrayOpsD_sum(self->weights, self->mu);
+	ekArrayOpsD_scalarDiv(self->weights, self->mu, sum);
+
+	ekCMAConstants_setupFromWeights(&(self->constants), N, self->weights, self->mu);
+	self->eigenUpdatePeriod = fmax(1.0, 1.0 / (10.0 * N * (self->constants.c1 + self->constants.cMu)));
+	self->nbUpdatesBestFitnessStalledLimit = 10 + floor((30.0 * N) / lambda);
+	self->nbUpdates = 0;
+
+	ekRandomizer_init(&(self->randomizer), ekRandomizerSize_1024);
+	ekRandomizer_seed(&(self->randomizer), 42);
+
+	/* Instances states, padded to a whole number of lanes */
+	self->sigma = newArray(double, S);
+	self->xMean = newArray(double, N * S);
+	self->sigmaPath = newArray(double, N * S);
+	self->cPath = newArray(double, N * S);
+	self->C = newArray(double, N * N * S);
+	self->B = newArray(double, N * N * S);
+	self->D = newArray(double, N * S);
+	self->BD = newArray(double, N * N * S);
+
+	/* Populations */
+	self->X = newArray(double, lambda * N * S);
+	self->Z = newArray(double, lambda * N * S);
+	self->fitnesses = newArray(double, lambda * S);
+	self->ranks = newArray(size_t, lambda * S);
+
+	self->bestX = newArray(double, N * S);
+	self->bestFitness = newArray(double, S);
+	self->nbUpdatesBestFitnessStalled = newArray(size_t, S);
+	self->stopCriteria = newArray(enum ekStopCriterionId, S);
+
+	/* Intermediate results storage */
+	self->tmpPopulation = newArray(double, self->mu * N * S);
+	self->tmpMatrices = newArray(double, 2 * N * N * S);
+	self->tmpVectors = newArray(double, 2 * N * S);
+	self->tmpScalars = newArray(double, 3 * S);
+	self->tmpPoint = newArray(double, N);
+
+	if (N > ekBatchCMA_jacobiMaxN) {
+		ekEigenSolver_init(&(self->eigenSolver), N);
+		ekMatrix_init(&(self->eigenC), N, N);
+		ekMatrix_init(&(self->eigenB), N, N);
+		self->eigenValues = newArray(double, N);
+	}
+
+	ekBatchCMA_setSigma(self, 1.0, 10e-12);
+	ekArrayOpsD_fill(self->xMean, N * S, 0.0);
+
+	return 1;
+}
+
+
+
+void
+ekBatchCMA_destroy(ekBatchCMA* self) {
+	free(self->weights);
+	ekRandomizer_destroy(&(self->randomizer));
+
+	free(self->sigma);
+	free(self->xMean);
+	free(self->sigmaPath);
+	free(self->cPath);
+	free(self->C);
+	free(self->B);
+	free(self->D);
+	free(self->BD);
+
+	free(self->X);
+	free(self->Z);
+	free(self->fitnesses);
+	free(self->ranks);
+
+	free(self->bestX);
+	free(self->bestFitness);
+	free(self->nbUpdatesBestFitnessStalled);
+	free(self->stopCriteria);
+
+	free(self->tmpPopulation);
+	free(self->tmpMatrices);
+	free(self->tmpVectors);
+	free(self->tmpScalars);
+	free(self->tmpPoint);
+
+	if (self->N > ekBatchCMA_jacobiMaxN) {
+		ekEigenSolver_destroy(&(self->eigenSolver));
+		ekMatrix_destroy(&(self->eigenC));
+		ekMatrix_destroy(&(self->eigenB));
+		free(self->eigenValues);
+	}
+}
+
+
+
+void
+ekBatchCMA_setSigma(ekBatchCMA* self, double sigmaInit, double sigmaStop) {
+	self->sigmaInit = sigmaInit;
+	self->sigmaStop = sigmaStop;
+}
+
+
+
+/* --- Strided copies ------------------------------------------------------ */
+
+static void
+ekBatchCMA_gather(const ekBatchCMA* self, const double* src, size_t k, double* x) {
+	size_t i;
+
+	for(i = 0; i < self->N; ++i)
+		x[i] = src[ekBatchCMA_vec(self, i) + k];
+}
+
+
+
+static void
+ekBatchCMA_scatter(const ekBatchCMA* self, double* dst, size_t k, const double* x) {
+	size_t i;
+
+	for(i = 0; i < self->N; ++i)
+		dst[ekBatchCMA_vec(self, i) + k] = x[i];
+}
+
+
+
+void
+ekBatchCMA_setXMean(ekBatchCMA* self, size_t k, const double* x) {
+	ekBatchCMA_scatter(self, self->xMean, k, x);
+}
+
+
+
+void
+ekBatchCMA_getXMean(const ekBatchCMA* self, size_t k, double* x) {
+	ekBatchCMA_gather(self, self->xMean, k, x);
+}
+
+
+
+void
+ekBatchCMA_getPoint(const ekBatchCMA* self, size_t j, size_t k, double* x) {
+	ekBatchCMA_gather(self, self->X + ekBatchCMA_pop(self, j, 0), k, x);
+}
+
+
+
+void
+ekBatchCMA_getBestPoint(const ekBatchCMA* self, size_t k, double* x) {
+	ekBatchCMA_gather(self, self->bestX, k, x);
+}
+
+
+
+/* --- Lane kernels, on n instances ---------------------------------------- */
+
+/* out += a * b */
+static void
+ekBatchCMA_mulAcc(double* restrict out, const double* restrict a, const double* restrict b, size_t n) {
+	size_t i, l;
+
+	ekBatchCMA_forEach(i, l, n)
+		out[i + l] += a[i + l] * b[i + l];
+}
+
+
+
+/* out += w * a * b */
+static void
+ekBatchCMA_scaledMulAcc(double* restrict out, double w, const double* restrict a, const double* restrict b, size_t n) {
+	size_t i, l;
+
+	ekBatchCMA_forEach(i, l, n)
+		out[i + l] += w * a[i + l] * b[i + l];
+}
+
+
+
+/* out = alpha * out + a * b */
+static void
+ekBatchCMA_blend(double* restrict out, double alpha, const double* restrict a, const double* restrict b, size_t n) {
+	size_t i, l;
+
+	ekBatchCMA_forEach(i, l, n)
+		out[i + l] = alpha * out[i + l] + a[i + l] * b[i + l];
+}
+
+
+
+/* out = a + b * out */
+static void
+ekBatchCMA_mulAdd(double* restrict out, const double* restrict a, const double* restrict b, size_t n) {
+	size_t i, l;
+
+	ekBatchCMA_forEach(i, l, n)
+		out[i + l] = a[i + l] + b[i + l] * out[i + l];
+}
+
+
+
+/* out = a * b */
+static void
+ekBatchCMA_mul(double* restrict out, const double* restrict a, const double* restrict b, size_t n) {
+	size_t i, l;
+
+	ekBatchCMA_forEach(i, l, n)
+		out[i + l] = a[i + l] * b[i + l];
+}
+
+
+
+/* out *= a */
+static void
+ekBatchCMA_scale(double* restrict out, const double* restrict a, size_t n) {
+	size_t i, l;
+
+	ekBatchCMA_forEach(i, l, n)
+		out[i + l] *= a[i + l];
+}
+
+
+
+/* (x, y) = (c * x - s * y, s * x + c * y) */
+static void
+ekBatchCMA_rotate(double* restrict x, double* restrict y, const double* restrict c, const double* restrict s, size_t n) {
+	size_t i, l;
+	double a, b;
+
+	ekBatchCMA_forEach(i, l, n) {
+		a = x[i + l];
+		b = y[i + l];
+		x[i + l] = c[i + l] * a - s[i + l] * b;
+		y[i + l] = s[i + l] * a + c[i + l] * b;
+	}
+}
+
+
+
+/* --- Lockstep matrix operations ------------------------------------------ */
+
+/* Sets every matrix to the identity */
+static void
+ekBatchCMA_setAsIdentity(const ekBatchCMA* self, double* M) {
+	size_t col, row;
+
+	for(col = 0; col < self->N; ++col)
+		for(row = 0; row < self->N; ++row)
+			ekArrayOpsD_fill(M + ekBatchCMA_mat(self, col, row), self->stride, (col == row) ? 1.0 : 0.0);
+}
+
+
+
+/* Computes v = M u for every instance */
+static void
+ekBatchCMA_vectorProd(const ekBatchCMA* self, const double* M, const double* u, double* v) {
+	size_t col, row;
+	double* out;
+
+	for(row = 0; row < self->N; ++row) {
+		out = v + ekBatchCMA_vec(self, row);
+		ekArrayOpsD_fill(out, self->stride, 0.0);
+
+		for(col = 0; col < self->N; ++col)
+			ekBatchCMA_mulAcc(out, M + ekBatchCMA_mat(self, col, row), u + ekBatchCMA_vec(self, col), self->stride);
+	}
+}
+
+
+
+/* Computes P = M Q, or P = M^T Q if transposeM is set, for every instance */
+static void
+ekBatchCMA_matrixProd(const ekBatchCMA* self, const double* M, const double* Q, double* P, int transposeM) {
+	size_t col, row, i;
+	double* out;
+
+	for(col = 0; col < self->N; ++col) {
+		for(row = 0; row < self->N; ++row) {
+			out = P + ekBatchCMA_mat(self, col, row);
+			ekArrayOpsD_fill(out, self->stride, 0.0);
+
+			for(i = 0; i < self->N; ++i)
+				ekBatchCMA_mulAcc(out, M + (transposeM ? ekBatchCMA_mat(self, row, i) : ekBatchCMA_mat(self, i, row)), Q + ekBatchCMA_mat(self, col, i), self->stride);
+		}
+	}
+}
+
+
+
+/* Applies the rotation in the (p, q) plane cancelling A[p][q], for every instance */
+static void
+ekBatchCMA_jacobiRotate(ekBatchCMA* self, double* A, double* V, size_t p, size_t q) {
+	size_t r, k, S;
+	double *c, *s, *t, *app, *aqq, *apq, *aqp;
+	double theta, tk;
+
+	S = self->stride;
+	c = self->tmpScalars;
+	s = c + S;
+	t = s + S;
+
+	app = A + ekBatchCMA_mat(self, p, p);
+	aqq = A + ekBatchCMA_mat(self, q, q);
+	apq = A + ekBatchCMA_mat(self, q, p);
+	aqp = A + ekBatchCMA_mat(self, p, q);
+
+	/* Rotation angles */
+	for(k = 0; k < S; ++k) {
+		theta = 0.5 * (aqq[k] - app[k]) / apq[k];
+		tk = 1.0 / (fabs(theta) + sqrt(theta * theta + 1.0));
+		tk = (theta < 0.0) ? -tk : tk;
+		tk = (apq[k] == 0.0) ? 0.0 : tk;
+
+		t[k] = tk;
+		c[k] = 1.0 / sqrt(tk * tk + 1.0);
+		s[k] = tk * c[k];
+	}
+
+	/* Columns p, q, then mirrored to the rows p, q */
+	for(r = 0; r < self->N; ++r) {
+		if ((r == p) || (r == q))
+			continue;
+
+		ekBatchCMA_rotate(A + ekBatchCMA_mat(self, p, r), A + ekBatchCMA_mat(self, q, r), c, s, S);
+		ekArrayOpsD_copy(A + ekBatchCMA_mat(self, r, p), A + ekBatchCMA_mat(self, p, r), S);
+		ekArrayOpsD_copy(A + ekBatchCMA_mat(self, r, q), A + ekBatchCMA_mat(self, q, r), S);
+	}
+
+	ekBatchCMA_scaledMulAcc(app, -1.0, t, apq, S);
+	ekBatchCMA_mulAcc(aqq, t, apq, S);
+	ekArrayOpsD_fill(apq, S, 0.0);
+	ekArrayOpsD_fill(aqp, S, 0.0);
+
+	/* Eigen vectors, as columns of V */
+	for(r = 0; r < self->N; ++r)
+		ekBatchCMA_rotate(V + ekBatchCMA_mat(self, p, r), V + ekBatchCMA_mat(self, q, r), c, s, S);
+}
+
+
+
+/* Returns 1 if A[p][q] is negligible for every instance */
+static int
+ekBatchCMA_jacobiNegligible(const ekBatchCMA* self, const double* A, size_t p, size_t q) {
+	size_t k;
+	const double *app, *aqq, *apq;
+
+	app = A + ekBatchCMA_mat(self, p, p);
+	aqq = A + ekBatchCMA_mat(self, q, q);
+	apq = A + ekBatchCMA_mat(self, q, p);
+
+	for(k = 0; k < self->stride; ++k)
+		if (apq[k] * apq[k] > ekBatchCMA_jacobiTolerance * fabs(app[k] * aqq[k]))
+			return 0;
+
+	return 1;
+}
+
+
+
+/* Returns 1 if the off-diagonal part of every matrix is negligible */
+static int
+ekBatchCMA_jacobiConverged(ekBatchCMA* self, const double* A) {
+	size_t p, q, k;
+	double *off, *diag;
+	const double* a;
+
+	off = self->tmpScalars;
+	diag = off + self->stride;
+	ekArrayOpsD_fill(off, 2 * self->stride, 0.0);
+
+	for(p = 0; p < self->N; ++p) {
+		for(q = 0; q < self->N; ++q) {
+			a = A + ekBatchCMA_mat(self, q, p);
+			ekBatchCMA_mulAcc((p == q) ? diag : off, a, a, self->stride);
+		}
+	}
+
+	for(k = 0; k < self->stride; ++k)
+		if (off[k] > ekBatchCMA_jacobiTolerance * diag[k])
+			return 0;
+
+	return 1;
+}
+
+
+
+/* Decomposes C instance by instance, B getting the eigen vectors and A the eigen values */
+static void
+ekBatchCMA_eigenSolve(ekBatchCMA* self, double* A) {
+	size_t col, row, k, offset;
+
+	for(k = 0; k < self->stride; ++k) {
+		for(col = 0; col < self->N; ++col)
+			for(row = 0; row < self->N; ++row)
+				ekMatrix_at(&(self->eigenC), col, row) = self->C[ekBatchCMA_mat(self, col, row) + k];
+
+		/* A failure keeps the previous decomposition */
+		if (!ekEigenSolver_solve(&(self->eigenSolver), &(self->eigenC), &(self->eigenB), self->eigenValues)) {
+			if (self->stopCriteria[k] == ekStopCriterionId_None)
+				self->stopCriteria[k] = ekStopCriterionId_EigenSolverFailure;
+
+			for(row = 0; row < self->N; ++row) {
+				offset = ekBatchCMA_vec(self, row) + k;
+				A[ekBatchCMA_mat(self, row, row) + k] = self->D[offset] * self->D[offset];
+			}
+			continue;
+		}
+
+		for(col = 0; col < self->N; ++col) {
+			for(row = 0; row < self->N; ++row)
+				self->B[ekBatchCMA_mat(self, col, row) + k] = ekMatrix_at(&(self->eigenB), col, row);
+			A[ekBatchCMA_mat(self, col, col) + k] = self->eigenValues[col];
+		}
+	}
+}
+
+
+
+/*
+   Cyclic Jacobi on all the instances, A converging to D^2 and B accumulating
+   the rotations. C changes little between two updates, so starting from
+   A = B^T C B, which is almost diagonal, saves most of the sweeps.
+ */
+static void
+ekBatchCMA_jacobi(ekBatchCMA* self, double* A) {
+	size_t col, row, sweep, N;
+
+	N = self->N;
+	ekBatchCMA_matrixProd(self, self->C, self->B, A + N * N * self->stride, 0);
+	ekBatchCMA_matrixProd(self, self->B, A + N * N * self->stride, A, 1);
+
+	for(sweep = 0; (sweep < ekBatchCMA_jacobiMaxSweeps) && (!ekBatchCMA_jacobiConverged(self, A)); ++sweep)
+		for(row = 0; row < N; ++row)
+			for(col = row + 1; col < N; ++col)
+				if (!ekBatchCMA_jacobiNegligible(self, A, row, col))
+					ekBatchCMA_jacobiRotate(self, A, self->B, row, col);
+}
+
+
+
+/* Updates B, D and BD from C, for every instance */
+static void
+ekBatchCMA_covUpdate(ekBatchCMA* self) {
+	size_t col, row, k, S, N;
+	double *A, *d;
+	const double* a;
+
+	S = self->stride;
+	N = self->N;
+	A = self->tmpMatrices;
+
+	/* Only the diagonal of A, the eigen values, is read below */
+	if (N > ekBatchCMA_jacobiMaxN)
+		ekBatchCMA_eigenSolve(self, A);
+	else
+		ekBatchCMA_jacobi(self, A);
+
+	/* D, failing for an instance with a negative eigen value */
+	for(row = 0; row < N; ++row) {
+		a = A + ekBatchCMA_mat(self, row, row);
+		d = self->D + ekBatchCMA_vec(self, row);
+		for(k = 0; k < S; ++k) {
+			if ((a[k] < 0.0) && (self->stopCriteria[k] == ekStopCriterionId_None))
+				self->stopCriteria[k] = ekStopCriterionId_EigenSolverFailure;
+
+			d[k] = sqrt(fmax(a[k], 0.0));
+		}
+	}
+
+	/* BD = B x diag(D) */
+	for(col = 0; col < N; ++col)
+		for(row = 0; row < N; ++row)
+			ekBatchCMA_mul(self->BD + ekBatchCMA_mat(self, col, row), self->B + ekBatchCMA_mat(self, col, row), self->D + ekBatchCMA_vec(self, col), S);
+}
+
+
+
+/* --- Iterations ---------------------------------------------------------- */
+
+void
+ekBatchCMA_start(ekBatchCMA* self) {
+	size_t k, NS;
+
+	NS = self->N * self->stride;
+
+	/* The padding instances are stopped from the start */
+	for(k = 0; k < self->stride; ++k) {
+		self->sigma[k] = (k < self->K) ? self->sigmaInit : 0.0;
+		self->bestFitness[k] = HUGE_VAL;
+		self->nbUpdatesBestFitnessStalled[k] = 0;
+		self->stopCriteria[k] = (k < self->K) ? ekStopCriterionId_None : ekStopCriterionId_LowSigma;
+	}
+
+	ekArrayOpsD_fill(self->sigmaPath, NS, 0.0);
+	ekArrayOpsD_fill(self->cPath, NS, 0.0);
+	ekArrayOpsD_fill(self->D, NS, 1.0);
+	ekBatchCMA_setAsIdentity(self, self->C);
+	ekBatchCMA_setAsIdentity(self, self->B);
+	ekBatchCMA_setAsIdentity(self, self->BD);
+
+	self->nbUpdates = 0;
+}
+
+
+
+void
+ekBatchCMA_sample(ekBatchCMA* self) {
+	size_t j, row;
+
+	/* Generate z */
+	ekArrayOpsD_gaussian(self->Z, self->lambda * self->N * self->stride, &(self->randomizer), 1.0);
+
+	/* Compute x = xMean + sigma * BD x z */
+	for(j = 0; j < self->lambda; ++j) {
+		ekBatchCMA_vectorProd(self, self->BD, self->Z + ekBatchCMA_pop(self, j, 0), self->X + ekBatchCMA_pop(self, j, 0));
+
+		for(row = 0; row < self->N; ++row)
+			ekBatchCMA_mulAdd(self->X + ekBatchCMA_pop(self, j, row), self->xMean + ekBatchCMA_vec(self, row), self->sigma, self->stride);
+	}
+}
+
+
+
+void
+ekBatchCMA_evaluateFunction(ekBatchCMA* self, double(*func)(const double*, size_t)) {
+	size_t j, k;
+
+	for(k = 0; k < self->stride; ++k) {
+		for(j = 0; j < self->lambda; ++j) {
+			if (self->stopCriteria[k] != ekStopCriterionId_None) {
+				ekBatchCMA_fitness(self, j, k) = HUGE_VAL;
+				continue;
+			}
+
+			ekBatchCMA_getPoint(self, j, k, self->tmpPoint);
+			ekBatchCMA_fitness(self, j, k) = func(self->tmpPoint, self->N);
+		}
+	}
+}
+
+
+
+/* Sorts the points of each instance by fitness, insertion sort being enough for small lambda */
+static void
+ekBatchCMA_sort(ekBatchCMA* self) {
+	size_t i, j, k, S;
+	size_t* ranks;
+	const double* fitnesses;
+
+	S = self->stride;
+	ranks = self->ranks;
+	fitnesses = self->fitnesses;
+
+	for(k = 0; k < S; ++k) {
+		for(i = 0; i < self->lambda; ++i) {
+			for(j = i; (j > 0) && (fitnesses[i * S + k] < fitnesses[ranks[(j - 1) * S + k] * S + k]); --j)
+				ranks[j * S + k] = ranks[(j - 1) * S + k];
+			ranks[j * S + k] = i;
+		}
+	}
+}
+
+
+
+/* Copies the coordinates of the mu best points of P to the temporary population */
+static void
+ekBatchCMA_selectBest(ekBatchCMA* self, const double* P) {
+	size_t j, i, k;
+	const size_t* ranks;
+	double* out;
+
+	for(j = 0; j < self->mu; ++j) {
+		ranks = self->ranks + j * self->stride;
+		for(i = 0; i < self->N; ++i) {
+			out = self->tmpPopulation + ekBatchCMA_pop(self, j, i);
+			for(k = 0; k < self->stride; ++k)
+				out[k] = P[ekBatchCMA_pop(self, ranks[k], i) + k];
+		}
+	}
+}
+
+
+
+/* Computes the weighted mean of the temporary population */
+static void
+ekBatchCMA_weightedMean(ekBatchCMA* self, double* mean) {
+	size_t j, i;
+
+	ekArrayOpsD_fill(mean, self->N * self->stride, 0.0);
+	for(j = 0; j < self->mu; ++j)
+		for(i = 0; i < self->N; ++i)
+			ekArrayOpsD_incMul(mean + ekBatchCMA_vec(self, i), self->tmpPopulation + ekBatchCMA_pop(self, j, i), self->stride, self->weights[j]);
+}
+
+
+
+static void
+ekBatchCMA_updateBest(ekBatchCMA* self) {
+	size_t i, k, S, best;
+
+	S = self->stride;
+	for(k = 0; k < S; ++k) {
+		best = self->ranks[k];
+		if ((self->nbUpdates == 0) || (self->bestFitness[k] > self->fitnesses[best * S + k])) {
+			self->bestFitness[k] = self->fitnesses[best * S + k];
+			for(i = 0; i < self->N; ++i)
+				self->bestX[ekBatchCMA_vec(self, i) + k] = self->X[ekBatchCMA_pop(self, best, i) + k];
+			self->nbUpdatesBestFitnessStalled[k] = 0;
+		}
+		else
+			self->nbUpdatesBestFitnessStalled[k] += 1;
+	}
+}
+
+
+
+void
+ekBatchCMA_update(ekBatchCMA* self) {
+	size_t i, j, col, row, k, S, N;
+	double *zMean, *tmp, *pathLength, *cFactors, *alpha, *c, *y;
+	double sigmaFactor, cFactor, HSigma, HSigmaLimit, HSigmaNorm;
+	const ekCMAConstants* cma;
+
+	S = self->stride;
+	N = self->N;
+	cma = &(self->constants);
+
+	zMean = self->tmpVectors;
+	tmp = zMean + N * S;
+	pathLength = self->tmpScalars;
+	cFactors = pathLength + S;
+	alpha = cFactors + S;
+
+	/* Selection */
+	ekBatchCMA_sort(self);
+	ekBatchCMA_updateBest(self);
+
+	/* Update xMean, then zMean */
+	ekBatchCMA_selectBest(self, self->X);
+	ekBatchCMA_weightedMean(self, self->xMean);
+
+	ekBatchCMA_selectBest(self, self->Z);
+	ekBatchCMA_weightedMean(self, zMean);
+
+	/* Cumulate sigma evolution path, with B x zMean */
+	ekBatchCMA_vectorProd(self, self->B, zMean, tmp);
+	sigmaFactor = sqrt(cma->muW * cma->cSigma * (2.0 - cma->cSigma));
+	ekArrayOpsD_scalarMul(self->sigmaPath, N * S, 1.0 - cma->cSigma);
+	ekArrayOpsD_incMul(self->sigmaPath, tmp, N * S, sigmaFactor);
+
+	ekArrayOpsD_fill(pathLength, S, 0.0);
+	for(i = 0; i < N; ++i)
+		ekBatchCMA_mulAcc(pathLength, self->sigmaPath + ekBatchCMA_vec(self, i), self->sigmaPath + ekBatchCMA_vec(self, i), S);
+
+	/* Compute HSigma and adapt sigma */
+	HSigmaNorm = sqrt(1.0 - pow(1.0 - cma->cSigma, 2.0 * (1.0 + self->nbUpdates))) * cma->chiN;
+	HSigmaLimit = 1.4 + 2.0 / (N + 1.0);
+	cFactor = sqrt(cma->muW * cma->cc * (2.0 - cma->cc));
+	for(k = 0; k < S; ++k) {
+		pathLength[k] = sqrt(pathLength[k]);
+		HSigma = (pathLength[k] / HSigmaNorm) < HSigmaLimit;
+		self->sigma[k] *= exp((cma->cSigma / cma->dSigma) * ((pathLength[k] / cma->chiN) - 1.0));
+		cFactors[k] = HSigma * cFactor;
+		alpha[k] = (1.0 - cma->c1 - cma->cMu) + (1.0 - HSigma) * cma->c1 * cma->cc * (2.0 - cma->cc);
+	}
+
+	/* Cumulate covariance matrix evolution path, with B x D x zMean */
+	ekBatchCMA_vectorProd(self, self->BD, zMean, tmp);
+	for(i = 0; i < N; ++i)
+		ekBatchCMA_blend(self->cPath + ekBatchCMA_vec(self, i), 1.0 - cma->cc, cFactors, tmp + ekBatchCMA_vec(self, i), S);
+
+	/* B x D x z_i of the mu best points, overwriting their z */
+	for(j = 0; j < self->mu; ++j) {
+		y = self->tmpPopulation + ekBatchCMA_pop(self, j, 0);
+		ekBatchCMA_vectorProd(self, self->BD, y, tmp);
+		ekArrayOpsD_copy(y, tmp, N * S);
+	}
+
+	/* C = alpha * C + c1 * cPath * cPath^T + cMu * sum w_i * BDz_i * BDz_i^T */
+	for(col = 0; col < N; ++col) {
+		for(row = 0; row < N; ++row) {
+			c = self->C + ekBatchCMA_mat(self, col, row);
+			ekBatchCMA_scale(c, alpha, S);
+			ekBatchCMA_scaledMulAcc(c, cma->c1, self->cPath + ekBatchCMA_vec(self, col), self->cPath + ekBatchCMA_vec(self, row), S);
+
+			for(j = 0; j < self->mu; ++j) {
+				y = self->tmpPopulation + ekBatchCMA_pop(self, j, 0);
+				ekBatchCMA_scaledMulAcc(c, cma->cMu * self->weights[j], y + ekBatchCMA_vec(self, col), y + ekBatchCMA_vec(self, row), S);
+			}
+		}
+	}
+
+	/* Update B and D from C */
+	if ((self->eigenUpdatePeriod == 1) || (self->nbUpdates % self->eigenUpdatePeriod == 0))
+		ekBatchCMA_covUpdate(self);
+
+	self->nbUpdates += 1;
+}
+
+
+
+size_t
+ekBatchCMA_stop(ekBatchCMA* self) {
+	size_t i, k, ret;
+	double d, DMin, DMax;
+
+	ret = 0;
+	for(k = 0; k < self->stride; ++k) {
+		if (self->stopCriteria[k] == ekStopCriterionId_None) {
+			DMin = DMax = self->D[k];
+			for(i = 1; i < self->N; ++i) {
+				d = self->D[ekBatchCMA_vec(self, i) + k];
+				DMin = fmin(DMin, d);
+				DMax = fmax(DMax, d);
+			}
+
+			if (self->sigma[k] <= self->sigmaStop)
+				self->stopCriteria[k] = ekStopCriterionId_LowSigma;
+			else if (DMax >= 1e14 * DMin)
+				self->stopCriteria[k] = ekStopCriterionId_ConditionCov;
+			else if (self->nbUpdatesBestFitnessStalled[k] > self->nbUpdatesBestFitnessStalledLimit)
+				self->stopCriteria[k] = ekStopCriterionId_BestFitnessStall;
+		}
+
+		/* Freeze the stopped instances */
+		if (self->stopCriteria[k] != ekStopCriterionId_None)
+			self->sigma[k] = 0.0;
+		else
+			ret += 1;
+	}
+
+	return ret;
+}
@@ -11,41 +11,63 @@
 #include "eskit/Macros.h"
 #include "eskit/ArrayOps.h"
 #include "eskit/CMA.h"
+#include "eskit/Checkpoint.h"
 #include "eskit/Optimizer.h"
 
 
 
 static void
-ekCMA_allocate(ekCMA* self, size_t N) {
+ekCMA_allocate(ekCMA* self, size_t N, ekArena* arena) {
+	self->arena = arena;
+
 	/* Allocation of vectors and matrixes */
-	self->sigmaPath = newArray(double, N);
-	self->cPath = newArray(double, N);
-	ekMatrix_init(&(self->B), N, N);
-	ekMatrix_init(&(self->C), N, N);
-	ekMatrix_init(&(self->BD), N, N);
-	self->D = newArray(double, N);
+	self->sigmaPath = ekArena_newArray(arena, double, N);
+	self->cPath = ekArena_newArray(arena, double, N);
+	ekMatrix_initFromArena(&(self->B), N, N, arena);
+	ekMatrix_initFromArena(&(self->C), N, N, arena);
+	ekMatrix_initFromArena(&(self->BD), N, N, arena);
+	self->D = ekArena_newArray(arena, double, N);
 
 	/* Allocation of temporary vectors and matrixes */
-	self->tmpVector = newArray(double, N);
+	self->tmpVector = ekArena_newArray(arena, double, N);
 
 	/* Eigen solver init */
-	ekEigenSolver_init(&(self->eigenSolver), N);
+	ekEigenSolver_initFromArena(&(self->eigenSolver), N, arena);
 }
 
 
 
 void
 ekCMA_init(ekCMA* self, size_t N) {
-	ekCMA_allocate(self, N);
+	ekCMA_initFromArena(self, N, NULL);
+}
+
+
+
+int
+ekCMA_initFromArena(ekCMA* self, size_t N, ekArena* arena) {
+	/* Checked at once, the allocations below can then not fail */
+	if ((arena != NULL) && (ekArena_remaining(arena) < ekCMA_arenaSize(N)))
+		return 0;
+
+	ekCMA_allocate(self, N, arena);
 	ekCMA_setSigma(self, 1.0, 10e-12);
 	
 	self->hasCustomCov = 0;
+	self->implicitC = 0;
+	self->implicitB = 0;
+
+	return 1;
 }
 
 
 
 void
 ekCMA_destroy(ekCMA* self) {
+	/* Arena memory is released by its owner */
+	if (self->arena != NULL)
+		return;
+
 	free(self->sigmaPath);
 	free(self->cPath);
 	ekMatrix_destroy(&(self->B));
@@ -59,6 +81,33 @@ ekCMA_destroy(ekCMA* self) {
 }
 
 
+
+size_t
+ekCMA_requiredMemory(size_t N) {
+	return 
+		4 * N * sizeof(double) +
+		3 * ekMatrix_requiredMemory(N, N) +
+		ekEigenSolver_requiredMemory(N);
+}
+
+
+
+size_t
+ekCMA_memoryUsage(const ekCMA* self) {
+	return ekCMA_requiredMemory(ekMatrix_nbRows(&(self->C)));
+}
+
+
+
+size_t
+ekCMA_arenaSize(size_t N) {
+	return
+		4 * ekArena_alignedSize(N * sizeof(double)) +
+		3 * ekMatrix_arenaSize(N, N) +
+		ekEigenSolver_arenaSize(N);
+}
+
+
 void
 ekCMA_setSigma(ekCMA* self, double sigmaInit, double sigmaStop) {
 	self->sigmaInit = sigmaInit;
@@ -86,15 +135,40 @@ ekCMA_sigma(const ekCMA* self) {
 
 
 
+/* Writes the identity matrices left implicit since the start */
+static void
+ekCMA_materializeC(ekCMA* self) {
+	if (self->implicitC) {
+		ekMatrix_setAsIdentity(&(self->C));
+		self->implicitC = 0;
+	}
+}
+
+
+
+static void
+ekCMA_materializeB(ekCMA* self) {
+	if (self->implicitB) {
+		ekMatrix_setAsIdentity(&(self->B));
+		ekMatrix_setAsIdentity(&(self->BD));
+		self->implicitB = 0;
+	}
+}
+
+
+
 const ekMatrix*
-ekCMA_C(const ekCMA* self) {
+ekCMA_C(ekCMA* self) {
+	/* Writing the implicit identity does not change the distribution */
+	ekCMA_materializeC(self);
 	return &(self->C);
 }
 
 
 
 const ekMatrix*
-ekCMA_B(const ekCMA* self) {
+ekCMA_B(ekCMA* self) {
+	ekCMA_materializeB(self);
 	return &(self->B);
 }
 
@@ -124,6 +198,7 @@ ekCMA_covUpdate(ekCMA* self) {
 
 	ekArrayOpsD_sqrt(self->D, ekMatrix_nbCols(&(self->C)));
 	ekMatrix_diagProd(&(self->B), self->D, &(self->BD));
+	self->implicitB = 0;
 }
 
 
@@ -146,15 +221,15 @@ ekCMA_start(ekCMA* self, ekOptimizer* optim) {
 	ekArrayOpsD_fill(self->sigmaPath, N, 0.0);
 	ekArrayOpsD_fill(self->cPath, N, 0.0);
 
-	/* Covariance init */
-	ekMatrix_setAsIdentity(&(self->C));
+	/* Covariance init, the identity being left implicit until the first update */
 	if (self->hasCustomCov) {
+		self->implicitC = 0;
 		ekCMA_covUpdate(self);
 		self->hasCustomCov = 0;
 	}
 	else {
-		ekMatrix_setAsIdentity(&(self->B));
-		ekMatrix_setAsIdentity(&(self->BD));
+		self->implicitC = 1;
+		self->implicitB = 1;
 		ekArrayOpsD_fill(self->D, N, 1.0);
 	}
 }
@@ -173,7 +248,10 @@ ekCMA_update(ekCMA* self, ekOptimizer* optim) {
 
 	/* Compute B x zMean */
 	B_zMean = self->tmpVector;
-	ekMatrix_vectorProd(&(self->B), ekOptimizer_zMean(optim), B_zMean);
+	if (self->implicitB)
+		ekArrayOpsD_copy(B_zMean, ekOptimizer_zMean(optim), N);
+	else
+		ekMatrix_vectorProd(&(self->B), ekOptimizer_zMean(optim), B_zMean);
 
 	/* Cumulate sigma evolution path */
 	ekArrayOpsD_scalarMul(self->sigmaPath, N, 1.0 - cma->cSigma);
@@ -182,7 +260,10 @@ ekCMA_update(ekCMA* self, ekOptimizer* optim) {
 
 	/* Compute B x D x zMean */
 	B_D_zMean = self->tmpVector;
-	ekMatrix_vectorProd(&(self->BD), ekOptimizer_zMean(optim), B_D_zMean);
+	if (self->implicitB)
+		ekArrayOpsD_copy(B_D_zMean, ekOptimizer_zMean(optim), N);
+	else
+		ekMatrix_vectorProd(&(self->BD), ekOptimizer_zMean(optim), B_D_zMean);
 
 	/* Compute HSigma */
 	HSigma = sigmaPathLength / sqrt(1.0 - pow(1.0 - cma->cSigma, 2.0 * (1.0 + ekOptimizer_nbUpdates(optim)))) / cma->chiN < (1.4 + 2.0 / (N + 1.0));
@@ -195,18 +276,31 @@ ekCMA_update(ekCMA* self, ekOptimizer* optim) {
 	self->sigma *= exp((cma->cSigma / cma->dSigma) * ((sigmaPathLength / cma->chiN) - 1.0));
 
 	/* Adapt covariance matrix C */
+	ekCMA_materializeC(self);
 	ekMatrix_scalarMul(&(self->C), (1.0 - cma->c1 - cma->cMu) + (1.0 - HSigma) * cma->c1 * cma->cc * (2.0 - cma->cc)); /* C *= alpha * C */
 	ekMatrix_incMulCross(&(self->C), self->cPath, cma->c1); /* C += c1 * cPath * cPath^T  */
 	
 	for(i = 0; i < ekOptimizer_mu(optim); ++i) {
 		/* C += cMu * cPath * BDz_i * BDz_i^T */
-		ekMatrix_vectorProd(&(self->BD), ekOptimizer_point(optim, i).z, self->tmpVector);
+		if (self->implicitB)
+			ekArrayOpsD_copy(self->tmpVector, ekOptimizer_point(optim, i).z, N);
+		else
+			ekMatrix_vectorProd(&(self->BD), ekOptimizer_point(optim, i).z, self->tmpVector);
 		ekMatrix_incMulCross(&(self->C), self->tmpVector, cma->cMu * ekOptimizer_weights(optim)[i]);
 	}
 
 	/* Update B and D from C */
-	if ((self->eigenUpdatePeriod == 1) || (ekOptimizer_nbUpdates(optim) % self->eigenUpdatePeriod == 0))
+	if ((self->eigenUpdatePeriod == 1) || (ekOptimizer_nbUpdates(optim) % self->eigenUpdatePeriod == 0)) {
+		ekProfile_begin(ekOptimizer_profile(optim), ekProfilePhase_EigenSolve);
+		if (ekOptimizer_trace(optim) != NULL)
+			ekTrace_begin(ekOptimizer_trace(optim), ekProfilePhase_EigenSolve, -1);
+
 		ekCMA_covUpdate(self);
+
+		if (ekOptimizer_trace(optim) != NULL)
+			ekTrace_end(ekOptimizer_trace(optim), ekProfilePhase_EigenSolve, -1);
+		ekProfile_end(ekOptimizer_profile(optim), ekProfilePhase_EigenSolve);
+	}
 }
 
 
@@ -221,7 +315,10 @@ ekCMA_samplePoint(ekCMA* self, ekOptimizer* optim, double* x, double* z) {
 	ekArrayOpsD_gaussian(z, N, ekOptimizer_getRandomizer(optim), 1.0);
 
 	/* Compute x */
-	ekMatrix_vectorProd(&(self->BD), z, x);
+	if (self->implicitB)
+		ekArrayOpsD_copy(x, z, N);
+	else
+		ekMatrix_vectorProd(&(self->BD), z, x);
 	ekArrayOpsD_scalarMul(x, N, self->sigma);	
 	ekArrayOpsD_inc(x, ekOptimizer_xMean(optim), N);
 }
@@ -229,18 +326,36 @@ ekCMA_samplePoint(ekCMA* self, ekOptimizer* optim, double* x, double* z) {
 
 
 static void
-ekCMA_sampleCloud(ekCMA* self, ekOptimizer* optim, ekMatrix* x, ekMatrix* z) {
-	size_t i;
+ekCMA_sampleBlock(void* data, ekOptimizer* optim, ekRandomizer* randomizer, ekMatrix* x, ekMatrix* z, size_t begin, size_t end) {
+	size_t i, N;
+	double *xCol, *zCol;
+	ekCMA* self;
+
+	self = (ekCMA*)data;
+	N = ekMatrix_nbRows(x);
+
+	for(i = begin; i < end; ++i) {
+		xCol = ekMatrix_col(x, i);
+		zCol = ekMatrix_col(z, i);
+
+		/* Generate z */
+		ekArrayOpsD_gaussian(zCol, N, randomizer, 1.0);
+
+		/* Compute x */
+		if (self->implicitB)
+			ekArrayOpsD_copy(xCol, zCol, N);
+		else
+			ekMatrix_vectorProd(&(self->BD), zCol, xCol);
+		ekArrayOpsD_scalarMul(xCol, N, self->sigma);
+		ekArrayOpsD_inc(xCol, ekOptimizer_xMean(optim), N);
+	}
+}
 
-	/* Generate z */
-	ekMatrix_setAsGaussian(z, ekOptimizer_getRandomizer(optim), 1.0);
 
-	/* Compute x */
-	ekMatrix_matrixProd(&(self->BD), z, x);
-	ekMatrix_scalarMul(x, self->sigma);
 
-	for(i = 0; i < ekMatrix_nbCols(x); ++i)
-		ekArrayOpsD_inc(ekMatrix_col(x, i), ekOptimizer_xMean(optim), ekMatrix_nbRows(x));
+static void
+ekCMA_sampleCloud(ekCMA* self, ekOptimizer* optim, ekMatrix* x, ekMatrix* z) {
+	ekOptimizer_sampleBlocks(optim, x, z, ekCMA_sampleBlock, self);
 }
 
 
@@ -266,7 +381,7 @@ ekCMA_stop(ekCMA* self, ekOptimizer* optim) {
 
 		for(j = 0; j < N; ++j) {
 			a = ekOptimizer_xMean(optim)[j];
-			b = a + factor * ekMatrix_at(&(self->B), i, j);
+			b = a + factor * (self->implicitB ? (i == j) : ekMatrix_at(&(self->B), i, j));
 			
 			if (fabs(a - b) > DBL_EPSILON)
 				break;
@@ -298,6 +413,78 @@ ekCMA_stop(ekCMA* self, ekOptimizer* optim) {
 
 
 
+static int
+ekCMA_save(ekCMA* self, ekOptimizer* optim, FILE* file) {
+	size_t N;
+
+	N = ekOptimizer_N(optim);
+
+	ekCMA_materializeC(self);
+	ekCMA_materializeB(self);
+
+	return
+		ekCheckpoint_writeDouble(file, self->sigmaInit) &&
+		ekCheckpoint_writeDouble(file, self->sigmaStop) &&
+		ekCheckpoint_writeDouble(file, self->sigma) &&
+		ekCheckpoint_write(file, &(self->constants), sizeof(ekCMAConstants)) &&
+		ekCheckpoint_writeArray(file, self->sigmaPath, N) &&
+		ekCheckpoint_writeArray(file, self->cPath, N) &&
+		ekCheckpoint_writeMatrix(file, &(self->C)) &&
+		ekCheckpoint_writeMatrix(file, &(self->B)) &&
+		ekCheckpoint_writeMatrix(file, &(self->BD)) &&
+		ekCheckpoint_writeArray(file, self->D, N) &&
+		ekCheckpoint_write(file, &(self->eigenSolverFailure), sizeof(int)) &&
+		ekCheckpoint_writeSize(file, self->eigenUpdatePeriod);
+}
+
+
+
+static int
+ekCMA_load(ekCMA* self, ekOptimizer* optim, FILE* file) {
+	size_t N;
+
+	N = ekOptimizer_N(optim);
+
+	self->hasCustomCov = 0;
+	self->implicitC = 0;
+	self->implicitB = 0;
+	return
+		ekCheckpoint_readDouble(file, &(self->sigmaInit)) &&
+		ekCheckpoint_readDouble(file, &(self->sigmaStop)) &&
+		ekCheckpoint_readDouble(file, &(self->sigma)) &&
+		ekCheckpoint_read(file, &(self->constants), sizeof(ekCMAConstants)) &&
+		ekCheckpoint_readArray(file, self->sigmaPath, N) &&
+		ekCheckpoint_readArray(file, self->cPath, N) &&
+		ekCheckpoint_readMatrix(file, &(self->C)) &&
+		ekCheckpoint_readMatrix(file, &(self->B)) &&
+		ekCheckpoint_readMatrix(file, &(self->BD)) &&
+		ekCheckpoint_readArray(file, self->D, N) &&
+		ekCheckpoint_read(file, &(self->eigenSolverFailure), sizeof(int)) &&
+		ekCheckpoint_readSize(file, &(self->eigenUpdatePeriod));
+}
+
+
+
+static void
+ekCMA_project(ekCMA* self, ekOptimizer* optim, const double* x, double* z) {
+	size_t i, N;
+
+	N = ekOptimizer_N(optim);
+
+	/* Solve x = xMean + sigma B D z, B being orthogonal */
+	ekArrayOpsD_copy(self->tmpVector, x, N);
+	ekArrayOpsD_dec(self->tmpVector, ekOptimizer_xMean(optim), N);
+	ekArrayOpsD_scalarDiv(self->tmpVector, N, self->sigma);
+
+	if (self->implicitB)
+		ekArrayOpsD_copy(z, self->tmpVector, N);
+	else
+		for(i = 0; i < N; ++i)
+			z[i] = (self->D[i] > 0.0) ? ekArrayOpsD_dot(ekMatrix_col(&(self->B), i), self->tmpVector, N) / self->D[i] : 0.0;
+}
+
+
+
 /* --- ekCMA delegate --------------------------------------------------------- */
 
 static void
@@ -335,6 +522,39 @@ ekCMA_delegate_stop(ekDistribution* self, ekOptimizer* optim) {
 
 
 
+static int
+ekCMA_delegate_save(ekDistribution* self, ekOptimizer* optim, FILE* file) {
+	return ekCMA_save((ekCMA*)self->data, optim, file);
+}
+
+
+
+static int
+ekCMA_delegate_load(ekDistribution* self, ekOptimizer* optim, FILE* file) {
+	return ekCMA_load((ekCMA*)self->data, optim, file);
+}
+
+
+
+static void
+ekCMA_delegate_view(ekDistribution* self, ekOptimizer* optim, ekGenerationView* view) {
+	ekCMA* distrib;
+
+	distrib = (ekCMA*)self->data;
+	view->sigma = distrib->sigma;
+	view->DMin = ekArrayOpsD_min(distrib->D, ekOptimizer_N(optim));
+	view->DMax = ekArrayOpsD_max(distrib->D, ekOptimizer_N(optim));
+}
+
+
+
+static void
+ekCMA_delegate_project(ekDistribution* self, ekOptimizer* optim, const double* x, double* z) {
+	ekCMA_project((ekCMA*)self->data, optim, x, z);
+}
+
+
+
 const ekDistributionDelegate 
 ekCMA_DistributionDelegate =
 {
@@ -343,5 +563,9 @@ ekCMA_DistributionDelegate =
 	ekCMA_delegate_update,
 	ekCMA_delegate_samplePoint,
 	ekCMA_delegate_sampleCloud,
-	ekCMA_delegate_stop
+	ekCMA_delegate_stop,
+	ekCMA_delegate_save,
+	ekCMA_delegate_load,
+	ekCMA_delegate_view,
+	ekCMA_delegate_project
 };
@@ -19,13 +19,15 @@ static double sqr(double x) { return x * x; }
 
 void
 ekCMAConstants_setup(ekCMAConstants* self, ekOptimizer* optim) {
-	size_t N, mu;
+	ekCMAConstants_setupFromWeights(self, ekOptimizer_N(optim), ekOptimizer_weights(optim), ekOptimizer_mu(optim));
+}
+
 
-	N = ekOptimizer_N(optim);
-	mu = ekOptimizer_mu(optim);
 
+void
+ekCMAConstants_setupFromWeights(ekCMAConstants* self, size_t N, const double* weights, size_t mu) {
 	self->chiN = sqrt(N) * (1.0 - (1.0 / (4.0 * N)) + (1.0 / (21.0 * N * N)));	
-	self->muW = 1.0 / ekArrayOpsD_squareSum(ekOptimizer_weights(optim), mu);
+	self->muW = 1.0 / ekArrayOpsD_squareSum(weights, mu);
 	self->cSigma = (self->muW + 2.0) / (self->muW + N + 5.0);
 	self->dSigma = 1 + 2 * fmax(0.0, sqrt(((self->muW - 1.0) / (N + 1.0)) - 1.0)) + self->cSigma;
 	self->cc = (4.0 + self->muW / N) / (N + 4.0 + 2.0 * self->muW / N);
@@ -12,34 +12,74 @@
 #include "eskit/Matrix.h"
 #include "eskit/ArrayOps.h"
 #include "eskit/CSA.h"
+#include "eskit/Checkpoint.h"
 #include "eskit/Optimizer.h"
 
 
 
 static void
-ekCSA_allocate(ekCSA* self, size_t N) {
+ekCSA_allocate(ekCSA* self, size_t N, ekArena* arena) {
+	self->N = N;
+	self->arena = arena;
 	self->c = 1.0 / sqrt((double)N);
 	self->dampening = 1.0 / (2.0 * N * sqrt((double)N));
-	self->sigmaPath = newArray(double, N);
+	self->sigmaPath = ekArena_newArray(arena, double, N);
 }
 
 
 
 void
 ekCSA_init(ekCSA* self, size_t N) {
-	ekCSA_allocate(self, N);
+	ekCSA_initFromArena(self, N, NULL);
+}
+
+
+
+int
+ekCSA_initFromArena(ekCSA* self, size_t N, ekArena* arena) {
+	if ((arena != NULL) && (ekArena_remaining(arena) < ekCSA_arenaSize(N)))
+		return 0;
+
+	ekCSA_allocate(self, N, arena);
 	ekCSA_setSigma(self, 1.0, 10e-12);
+
+	return 1;
 }
 
 
 
 void
 ekCSA_destroy(ekCSA* self) {
+	/* Arena memory is released by its owner */
+	if (self->arena != NULL)
+		return;
+
 	free(self->sigmaPath);
 }
 
 
 
+size_t
+ekCSA_requiredMemory(size_t N) {
+	return N * sizeof(double);
+}
+
+
+
+size_t
+ekCSA_memoryUsage(const ekCSA* self) {
+	return ekCSA_requiredMemory(self->N);
+}
+
+
+
+size_t
+ekCSA_arenaSize(size_t N) {
+	return ekArena_alignedSize(N * sizeof(double));
+}
+
+
+
 void
 ekCSA_setSigma(ekCSA* self, double sigmaInit, double sigmaStop) {
 	self->sigmaInit = sigmaInit;
@@ -101,17 +141,32 @@ ekCSA_update(ekCSA* self, ekOptimizer* optim) {
 
 
 static void
-ekCSA_sampleCloud(ekCSA* self, ekOptimizer* optim, ekMatrix* x, ekMatrix* z) {
-	size_t i;
+ekCSA_sampleBlock(void* data, ekOptimizer* optim, ekRandomizer* randomizer, ekMatrix* x, ekMatrix* z, size_t begin, size_t end) {
+	size_t i, N;
+	double *xCol, *zCol;
+	ekCSA* self;
+
+	self = (ekCSA*)data;
+	N = ekMatrix_nbRows(x);
+
+	for(i = begin; i < end; ++i) {
+		xCol = ekMatrix_col(x, i);
+		zCol = ekMatrix_col(z, i);
+
+		/* Generate z */
+		ekArrayOpsD_gaussian(zCol, N, randomizer, 1.0);
+
+		/* Compute x */
+		ekArrayOpsD_copyMul(xCol, zCol, N, self->sigma);
+		ekArrayOpsD_inc(xCol, ekOptimizer_xMean(optim), N);
+	}
+}
 
-	/* Generate z */
-	ekMatrix_setAsGaussian(z, ekOptimizer_getRandomizer(optim), 1.0);
 
-	/* Compute x */
-	ekMatrix_copyMul(x, z, self->sigma);
 
-	for(i = 0; i < ekMatrix_nbCols(x); ++i)
-		ekArrayOpsD_inc(ekMatrix_col(x, i), ekOptimizer_xMean(optim), ekMatrix_nbRows(x));	
+static void
+ekCSA_sampleCloud(ekCSA* self, ekOptimizer* optim, ekMatrix* x, ekMatrix* z) {
+	ekOptimizer_sampleBlocks(optim, x, z, ekCSA_sampleBlock, self);
 }
 
 
@@ -142,6 +197,49 @@ ekCSA_stop(ekCSA* self, ekOptimizer* ESKIT_UNUSED(optim)) {
 
 
 
+static int
+ekCSA_save(ekCSA* self, ekOptimizer* optim, FILE* file) {
+	size_t N;
+
+	N = ekOptimizer_N(optim);
+
+	return
+		ekCheckpoint_writeDouble(file, self->sigmaInit) &&
+		ekCheckpoint_writeDouble(file, self->sigmaStop) &&
+		ekCheckpoint_writeDouble(file, self->sigma) &&
+		ekCheckpoint_writeArray(file, self->sigmaPath, N);
+}
+
+
+
+static int
+ekCSA_load(ekCSA* self, ekOptimizer* optim, FILE* file) {
+	size_t N;
+
+	N = ekOptimizer_N(optim);
+
+	return
+		ekCheckpoint_readDouble(file, &(self->sigmaInit)) &&
+		ekCheckpoint_readDouble(file, &(self->sigmaStop)) &&
+		ekCheckpoint_readDouble(file, &(self->sigma)) &&
+		ekCheckpoint_readArray(file, self->sigmaPath, N);
+}
+
+
+
+static void
+ekCSA_project(ekCSA* self, ekOptimizer* optim, const double* x, double* z) {
+	size_t N;
+
+	N = ekOptimizer_N(optim);
+
+	ekArrayOpsD_copy(z, x, N);
+	ekArrayOpsD_dec(z, ekOptimizer_xMean(optim), N);
+	ekArrayOpsD_scalarDiv(z, N, self->sigma);
+}
+
+
+
 /* --- IsotropicGaussian delegate ------------------------------------------- */
 
 static void
@@ -179,6 +277,36 @@ ekCSA_delegate_stop(ekDistribution* self, ekOptimizer* optim) {
 
 
 
+static int
+ekCSA_delegate_save(ekDistribution* self, ekOptimizer* optim, FILE* file) {
+	return ekCSA_save((ekCSA*)self->data, optim, file);
+}
+
+
+
+static int
+ekCSA_delegate_load(ekDistribution* self, ekOptimizer* optim, FILE* file) {
+	return ekCSA_load((ekCSA*)self->data, optim, file);
+}
+
+
+
+static void
+ekCSA_delegate_view(ekDistribution* self, ekOptimizer* ESKIT_UNUSED(optim), ekGenerationView* view) {
+	view->sigma = ((ekCSA*)self->data)->sigma;
+	view->DMin = 1.0;
+	view->DMax = 1.0;
+}
+
+
+
+static void
+ekCSA_delegate_project(ekDistribution* self, ekOptimizer* optim, const double* x, double* z) {
+	ekCSA_project((ekCSA*)self->data, optim, x, z);
+}
+
+
+
 const ekDistributionDelegate 
 ekCSA_DistributionDelegate =
 {
@@ -187,5 +315,9 @@ ekCSA_DistributionDelegate =
 	ekCSA_delegate_update,
 	ekCSA_delegate_samplePoint,
 	ekCSA_delegate_sampleCloud,
-	ekCSA_delegate_stop
+	ekCSA_delegate_stop,
+	ekCSA_delegate_save,
+	ekCSA_delegate_load,
+	ekCSA_delegate_view,
+	ekCSA_delegate_project
 };
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <string.h>
+#include "eskit/Checkpoint.h"
+
+
+
+int
+ekCheckpoint_write(FILE* file, const void* data, size_t size) {
+	if (size == 0)
+		return 1;
+
+	return fwrite(data, size, 1, file) == 1;
+}
+
+
+
+int
+ekCheckpoint_read(FILE* file, void* data, size_t size) {
+	if (size == 0)
+		return 1;
+
+	return fread(data, size, 1, file) == 1;
+}
+
+
+
+int
+ekCheckpoint_writeSize(FILE* file, size_t value) {
+	uint64_t tmp;
+
+	tmp = value;
+	return ekCheckpoint_write(file, &tmp, sizeof(uint64_t));
+}
+
+
+
+int
+ekCheckpoint_readSize(FILE* file, size_t* value) {
+	uint64_t tmp;
+
+	if (!ekCheckpoint_read(file, &tmp, sizeof(uint64_t)))
+		return 0;
+
+	*value = (size_t)tmp;
+	return 1;
+}
+
+
+
+int
+ekCheckpoint_writeDouble(FILE* file, double value) {
+	return ekCheckpoint_write(file, &value, sizeof(double));
+}
+
+
+
+int
+ekCheckpoint_readDouble(FILE* file, double* value) {
+	return ekCheckpoint_read(file, value, sizeof(double));
+}
+
+
+
+int
+ekCheckpoint_writeString(FILE* file, const char* str) {
+	size_t length;
+
+	length = strlen(str);
+	return
+		ekCheckpoint_writeSize(file, length) &&
+		ekCheckpoint_write(file, str, length);
+}
+
+
+
+int
+ekCheckpoint_checkString(FILE* file, const char* str) {
+	size_t length, count;
+	char buffer[64];
+
+	if (!ekCheckpoint_readSize(file, &length))
+		return 0;
+
+	if (length != strlen(str))
+		return 0;
+
+	/* Compared by chunks, loading a checkpoint does not allocate */
+	for( ; length > 0; length -= count, str += count) {
+		count = (length < sizeof(buffer)) ? length : sizeof(buffer);
+		if (!ekCheckpoint_read(file, buffer, count) || (memcmp(buffer, str, count) != 0))
+			return 0;
+	}
+
+	return 1;
+}
+
+
+
+int
+ekCheckpoint_writeArray(FILE* file, const double* u, size_t size) {
+	return ekCheckpoint_write(file, u, size * sizeof(double));
+}
+
+
+
+int
+ekCheckpoint_readArray(FILE* file, double* u, size_t size) {
+	return ekCheckpoint_read(file, u, size * sizeof(double));
+}
+
+
+
+int
+ekCheckpoint_writeMatrix(FILE* file, const ekMatrix* M) {
+	return
+		ekCheckpoint_writeSize(file, M->nbCols) &&
+		ekCheckpoint_writeSize(file, M->nbRows) &&
+		ekCheckpoint_writeArray(file, M->tuple, M->tupleSize);
+}
+
+
+
+int
+ekCheckpoint_readMatrix(FILE* file, ekMatrix* M) {
+	size_t nbCols, nbRows;
+
+	if (!(ekCheckpoint_readSize(file, &nbCols) && ekCheckpoint_readSize(file, &nbRows)))
+		return 0;
+
+	if ((nbCols != M->nbCols) || (nbRows != M->nbRows))
+		return 0;
+
+	return ekCheckpoint_readArray(file, M->tuple, M->tupleSize);
+}
+
+
+
+int
+ekCheckpoint_writeRandomizer(FILE* file, const ekRandomizer* randomizer) {
+	return
+		ekCheckpoint_write(file, &(randomizer->multiplier), sizeof(uint64_t)) &&
+		ekCheckpoint_write(file, &(randomizer->size), sizeof(uint32_t)) &&
+		ekCheckpoint_write(file, &(randomizer->carry), sizeof(uint32_t)) &&
+		ekCheckpoint_write(file, &(randomizer->index), sizeof(uint32_t)) &&
+		ekCheckpoint_write(file, randomizer->array, randomizer->size * sizeof(uint32_t));
+}
+
+
+
+int
+ekCheckpoint_readRandomizer(FILE* file, ekRandomizer* randomizer) {
+	uint64_t multiplier;
+	uint32_t size, carry, index;
+
+	if (!(ekCheckpoint_read(file, &multiplier, sizeof(uint64_t)) &&
+	      ekCheckpoint_read(file, &size, sizeof(uint32_t)) &&
+	      ekCheckpoint_read(file, &carry, sizeof(uint32_t)) &&
+	      ekCheckpoint_read(file, &index, sizeof(uint32_t))))
+		return 0;
+
+	/* The state may live in an arena, it is never reallocated */
+	if ((size != randomizer->size) || (index >= size))
+		return 0;
+
+	randomizer->multiplier = multiplier;
+	randomizer->carry = carry;
+	randomizer->index = index;
+	return ekCheckpoint_read(file, randomizer->array, size * sizeof(uint32_t));
+}
+
+
+
+int
+ekCheckpoint_skipRandomizer(FILE* file) {
+	uint64_t multiplier;
+	uint32_t size, carry, index, count;
+	uint32_t buffer[64];
+
+	if (!(ekCheckpoint_read(file, &multiplier, sizeof(uint64_t)) &&
+	      ekCheckpoint_read(file, &size, sizeof(uint32_t)) &&
+	      ekCheckpoint_read(file, &carry, sizeof(uint32_t)) &&
+	      ekCheckpoint_read(file, &index, sizeof(uint32_t))))
+		return 0;
+
+	if (index >= size)
+		return 0;
+
+	for( ; size > 0; size -= count) {
+		count = (size < 64) ? size : 64;
+		if (!ekCheckpoint_read(file, buffer, count * sizeof(uint32_t)))
+			return 0;
+	}
+
+	return 1;
+}
@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "eskit/Macros.h"
+#include "eskit/Socket.h"
+#include "eskit/Optimizer.h"
+#include "eskit/Coordinator.h"
+
+
+
+enum ekCoordinatorMessage {
+	ekCoordinatorMessage_Hello = 0,
+	ekCoordinatorMessage_Batch,
+	ekCoordinatorMessage_Result,
+	ekCoordinatorMessage_Bye
+};
+
+
+
+struct s_ekCoordinatorLink {
+	int fd;
+	int ready;                   /* Set once the worker hello is received */
+	ekSocketBuffer in, out;
+	size_t* inFlight;            /* Batches sent and not answered yet      */
+	size_t nbInFlight;
+};
+
+
+
+/* --- Coordinator --------------------------------------------------------- */
+
+int
+ekCoordinator_init(ekCoordinator* self, const char* address, size_t N, size_t batchSize, size_t depth) {
+	self->listenFd = ekSocket_listen(address, &(self->unixPath));
+	if (self->listenFd < 0)
+		return 0;
+
+	self->N = N;
+	self->batchSize = (batchSize > 0) ? batchSize : 1;
+	self->depth = (depth > 0) ? depth : 1;
+
+	self->links = NULL;
+	self->nbLinks = 0;
+	self->linksCapacity = 0;
+
+	self->tag = 0;
+	self->pending = NULL;
+	self->fitnesses = NULL;
+	self->capacity = 0;
+	self->nbRedispatches = 0;
+
+	return 1;
+}
+
+
+
+static void
+ekCoordinator_closeLink(struct s_ekCoordinatorLink* link) {
+	close(link->fd);
+	ekSocketBuffer_destroy(&(link->in));
+	ekSocketBuffer_destroy(&(link->out));
+	free(link->inFlight);
+}
+
+
+
+void
+ekCoordinator_destroy(ekCoordinator* self) {
+	size_t i;
+	unsigned char bye[ESKIT_SOCKET_HEADER_SIZE];
+
+	ekSocket_putHeader(bye, ekCoordinatorMessage_Bye, 0, 0, 0);
+
+	/* Best effort, a worker which does not get the bye sees the connection closed */
+	for(i = 0; i < self->nbLinks; ++i) {
+		send(self->links[i].fd, bye, sizeof(bye), MSG_NOSIGNAL);
+		ekCoordinator_closeLink(self->links + i);
+	}
+
+	close(self->listenFd);
+	if (self->unixPath != NULL) {
+		unlink(self->unixPath);
+		free(self->unixPath);
+	}
+
+	free(self->links);
+	free(self->pending);
+	free(self->fitnesses);
+}
+
+
+
+size_t
+ekCoordinator_nbWorkers(const ekCoordinator* self) {
+	size_t i, ret;
+
+	for(i = 0, ret = 0; i < self->nbLinks; ++i)
+		ret += self->links[i].ready;
+
+	return ret;
+}
+
+
+
+static void
+ekCoordinator_accept(ekCoordinator* self) {
+	int fd;
+	struct s_ekCoordinatorLink* link;
+
+	while(1) {
+		fd = ekSocket_accept(self->listenFd);
+		if (fd < 0)
+			return;
+
+		if (self->nbLinks == self->linksCapacity) {
+			self->linksCapacity = (self->linksCapacity > 0) ? 2 * self->linksCapacity : 8;
+			self->links = (struct s_ekCoordinatorLink*)realloc(self->links, self->linksCapacity * sizeof(struct s_ekCoordinatorLink));
+		}
+
+		link = self->links + self->nbLinks;
+		self->nbLinks += 1;
+
+		memset(link, 0, sizeof(*link));
+		link->fd = fd;
+		link->inFlight = newArray(size_t, self->depth);
+
+		ekSocket_putHeader(ekSocketBuffer_reserve(&(link->out), ESKIT_SOCKET_HEADER_SIZE), ekCoordinatorMessage_Hello, ESKIT_COORDINATOR_MAGIC, ESKIT_COORDINATOR_VERSION, self->N);
+		link->out.end += ESKIT_SOCKET_HEADER_SIZE;
+	}
+}
+
+
+
+/* Number of points of the batch starting at the point first */
+static size_t
+ekCoordinator_batchLength(const ekCoordinator* self, size_t first, size_t lambda) {
+	return (lambda - first < self->batchSize) ? lambda - first : self->batchSize;
+}
+
+
+
+static void
+ekCoordinator_sendBatch(ekCoordinator* self, struct s_ekCoordinatorLink* link, ekOptimizer* optim, size_t batch) {
+	size_t i, j, first, count;
+	const double* x;
+	unsigned char* p;
+
+	first = batch * self->batchSize;
+	count = ekCoordinator_batchLength(self, first, ekOptimizer_lambda(optim));
+
+	p = ekSocketBuffer_reserve(&(link->out), ESKIT_SOCKET_HEADER_SIZE + 8 * count * self->N);
+	link->out.end += ESKIT_SOCKET_HEADER_SIZE + 8 * count * self->N;
+
+	ekSocket_putHeader(p, ekCoordinatorMessage_Batch, self->tag, first, count);
+	p += ESKIT_SOCKET_HEADER_SIZE;
+	for(i = 0; i < count; ++i) {
+		x = optim->pointArray[first + i].x;
+		for(j = 0; j < self->N; ++j, p += 8)
+			ekSocket_putF64(p, x[j]);
+	}
+
+	link->inFlight[link->nbInFlight] = batch;
+	link->nbInFlight += 1;
+}
+
+
+
+/*
+   Handles the complete messages received on a link, returns the number of
+   batches done, or -1 if the link should be dropped
+ */
+static int
+ekCoordinator_receive(ekCoordinator* self, struct s_ekCoordinatorLink* link, size_t lambda) {
+	int ret;
+	size_t i, first, count, size;
+	uint32_t type;
+	const unsigned char* p;
+
+	ret = 0;
+	while(link->in.end - link->in.begin >= ESKIT_SOCKET_HEADER_SIZE) {
+		p = link->in.data + link->in.begin;
+		type = ekSocket_getU32(p);
+		first = ekSocket_getU32(p + 8);
+		count = ekSocket_getU32(p + 12);
+
+		if (type == ekCoordinatorMessage_Hello) {
+			if ((ekSocket_getU32(p + 4) != ESKIT_COORDINATOR_MAGIC) || (first != ESKIT_COORDINATOR_VERSION))
+				return -1;
+			link->ready = 1;
+			link->in.begin += ESKIT_SOCKET_HEADER_SIZE;
+			continue;
+		}
+
+		/* No batch is larger, whatever the generation */
+		if ((type != ekCoordinatorMessage_Result) || (count > self->batchSize))
+			return -1;
+
+		size = ESKIT_SOCKET_HEADER_SIZE + 8 * count;
+		if (link->in.end - link->in.begin < size)
+			break;
+		link->in.begin += size;
+
+		/* Results of a previous generation are dropped */
+		if (ekSocket_getU32(p + 4) != self->tag)
+			continue;
+
+		/* A result covers the whole batch, the last one being shorter */
+		for(i = 0; i < link->nbInFlight; ++i)
+			if (link->inFlight[i] * self->batchSize == first)
+				break;
+		if ((i == link->nbInFlight) || (count != ekCoordinator_batchLength(self, first, lambda)))
+			return -1;
+
+		link->nbInFlight -= 1;
+		link->inFlight[i] = link->inFlight[link->nbInFlight];
+
+		for(i = 0, p += ESKIT_SOCKET_HEADER_SIZE; i < count; ++i, p += 8)
+			self->fitnesses[first + i] = ekSocket_getF64(p);
+		ret += 1;
+	}
+
+	return ret;
+}
+
+
+
+int
+ekCoordinator_evaluate(ekCoordinator* self, ekOptimizer* optim, double timeout) {
+	int ret, lost, nbAnswered;
+	size_t i, lambda, nbBatches, nbDone, nbPending;
+	struct pollfd* fds;
+	struct s_ekCoordinatorLink* link;
+
+	lambda = ekOptimizer_lambda(optim);
+	nbBatches = (lambda + self->batchSize - 1) / self->batchSize;
+	if (self->capacity < lambda) {
+		free(self->pending);
+		free(self->fitnesses);
+		self->pending = newArray(size_t, lambda);
+		self->fitnesses = newArray(double, lambda);
+		self->capacity = lambda;
+	}
+
+	ekProfile_begin(ekOptimizer_profile(optim), ekProfilePhase_Evaluate);
+
+	/* A new tag, so that late results of a timed out generation are ignored */
+	self->tag += 1;
+	for(i = 0; i < self->nbLinks; ++i)
+		self->links[i].nbInFlight = 0;
+
+	for(i = 0; i < nbBatches; ++i)
+		self->pending[i] = nbBatches - i - 1;
+	nbPending = nbBatches;
+	nbDone = 0;
+
+	fds = NULL;
+	ret = 1;
+	while(nbDone < nbBatches) {
+		/* Keep each worker busy, up to depth batches ahead */
+		for(i = 0; i < self->nbLinks; ++i) {
+			link = self->links + i;
+			if (!link->ready)
+				continue;
+
+			while((link->nbInFlight < self->depth) && (nbPending > 0)) {
+				nbPending -= 1;
+				ekCoordinator_sendBatch(self, link, optim, self->pending[nbPending]);
+			}
+		}
+
+		fds = (struct pollfd*)realloc(fds, (self->nbLinks + 1) * sizeof(struct pollfd));
+		fds[0].fd = self->listenFd;
+		fds[0].events = POLLIN;
+		for(i = 0; i < self->nbLinks; ++i) {
+			link = self->links + i;
+			fds[i + 1].fd = link->fd;
+			fds[i + 1].events = POLLIN | ((link->out.begin < link->out.end) ? POLLOUT : 0);
+		}
+
+		if (poll(fds, self->nbLinks + 1, (timeout < HUGE_VAL) ? (int)ceil(1e3 * timeout) : -1) == 0) {
+			ret = 0;
+			break;
+		}
+
+		/* Backwards, since the lost links are swapped with the last one */
+		for(i = self->nbLinks; i > 0; --i) {
+			link = self->links + i - 1;
+			lost = 0;
+
+			if (fds[i].revents & POLLOUT)
+				lost = !ekSocket_flush(link->fd, &(link->out));
+
+			if ((!lost) && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+				lost = !ekSocket_read(link->fd, &(link->in));
+
+				nbAnswered = ekCoordinator_receive(self, link, lambda);
+				if (nbAnswered < 0)
+					lost = 1;
+				else
+					nbDone += nbAnswered;
+			}
+
+			if (lost) {
+				/* The batches of a lost worker go to the other workers */
+				for(; link->nbInFlight > 0; --(link->nbInFlight)) {
+					self->pending[nbPending] = link->inFlight[link->nbInFlight - 1];
+					nbPending += 1;
+					self->nbRedispatches += 1;
+				}
+
+				ekCoordinator_closeLink(link);
+				self->nbLinks -= 1;
+				*link = self->links[self->nbLinks];
+			}
+		}
+
+		if (fds[0].revents & POLLIN)
+			ekCoordinator_accept(self);
+	}
+
+	free(fds);
+
+	if (ret)
+		ekOptimizer_setFitnesses(optim, self->fitnesses);
+
+	ekProfile_end(ekOptimizer_profile(optim), ekProfilePhase_Evaluate);
+
+	return ret;
+}
+
+
+
+/* --- Worker -------------------------------------------------------------- */
+
+int
+ekCoordinator_runWorker(const char* address, double(*function)(const double*, size_t)) {
+	int fd, ret;
+	size_t i, j, N, first, count, capacity;
+	uint32_t type;
+	double* x;
+	unsigned char* data;
+	unsigned char header[ESKIT_SOCKET_HEADER_SIZE];
+
+	fd = ekSocket_connect(address);
+	if (fd < 0)
+		return 0;
+
+	ekSocket_putHeader(header, ekCoordinatorMessage_Hello, ESKIT_COORDINATOR_MAGIC, ESKIT_COORDINATOR_VERSION, 0);
+	if ((!ekSocket_sendAll(fd, header, sizeof(header))) ||
+	    (!ekSocket_recvAll(fd, header, sizeof(header))) ||
+	    (ekSocket_getU32(header) != ekCoordinatorMessage_Hello) ||
+	    (ekSocket_getU32(header + 4) != ESKIT_COORDINATOR_MAGIC) ||
+	    (ekSocket_getU32(header + 8) != ESKIT_COORDINATOR_VERSION)) {
+		close(fd);
+		return 0;
+	}
+	N = ekSocket_getU32(header + 12);
+
+	x = newArray(double, N);
+	data = NULL;
+	capacity = 0;
+
+	ret = 0;
+	while(ekSocket_recvAll(fd, header, sizeof(header))) {
+		type = ekSocket_getU32(header);
+		if (type == ekCoordinatorMessage_Bye) {
+			ret = 1;
+			break;
+		}
+		if (type != ekCoordinatorMessage_Batch)
+			break;
+
+		first = ekSocket_getU32(header + 8);
+		count = ekSocket_getU32(header + 12);
+
+		/* The fitnesses overwrite the points, once decoded */
+		if (capacity < ESKIT_SOCKET_HEADER_SIZE + 8 * count * N) {
+			capacity = ESKIT_SOCKET_HEADER_SIZE + 8 * count * N;
+			data = (unsigned char*)realloc(data, capacity);
+		}
+		if (!ekSocket_recvAll(fd, data + ESKIT_SOCKET_HEADER_SIZE, 8 * count * N))
+			break;
+
+		for(i = 0; i < count; ++i) {
+			for(j = 0; j < N; ++j)
+				x[j] = ekSocket_getF64(data + ESKIT_SOCKET_HEADER_SIZE + 8 * (i * N + j));
+			ekSocket_putF64(data + ESKIT_SOCKET_HEADER_SIZE + 8 * i, function(x, N));
+		}
+
+		ekSocket_putHeader(data, ekCoordinatorMessage_Result, ekSocket_getU32(header + 4), first, count);
+		if (!ekSocket_sendAll(fd, data, ESKIT_SOCKET_HEADER_SIZE + 8 * count))
+			break;
+	}
+
+	free(x);
+	free(data);
+	close(fd);
+
+	return ret;
+}
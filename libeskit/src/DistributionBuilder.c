@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "eskit/Macros.h"
+#include "eskit/CSA.h"
+#include "eskit/CMA.h"
+#include "eskit/SepCMA.h"
+#include "eskit/Optimizer.h"
+#include "eskit/DistributionBuilder.h"
+
+
+
+void
+ekDistribution_initFromBuilder(ekDistribution* self, const ekDistributionBuilder* builder, size_t N, double sigmaInit, double sigmaStop) {
+	self->data = builder->create(N, sigmaInit, sigmaStop);
+	self->delegate = *(builder->delegate);
+}
+
+
+
+void
+ekDistribution_destroy(ekDistribution* self, const ekDistributionBuilder* builder) {
+	builder->destroy(self->data);
+	free(self->data);
+}
+
+
+
+size_t
+ekDistributionBuilder_requiredMemory(const ekDistributionBuilder* self, size_t N, size_t lambda) {
+	return ekOptimizer_requiredMemory(N, lambda) + self->requiredMemory(N);
+}
+
+
+
+/* --- Distribution builders database -------------------------------------- */
+
+#define DECLARE_BUILDER(type) \
+static void* \
+ekDistributionBuilder_create_##type (size_t N, double sigmaInit, double sigmaStop) { \
+	type* ret; \
+\
+	ret = new(type); \
+	type##_init(ret, N); \
+	type##_setSigma(ret, sigmaInit, sigmaStop); \
+	return ret; \
+} \
+\
+static void \
+ekDistributionBuilder_destroy_##type (void* data) { \
+	type##_destroy((type*)data); \
+} \
+\
+static size_t \
+ekDistributionBuilder_requiredMemory_##type (size_t N) { \
+	return sizeof(type) + type##_requiredMemory(N); \
+} \
+\
+const ekDistributionBuilder \
+type##_DistributionBuilder = \
+{ \
+	ekDistributionBuilder_create_##type , \
+	ekDistributionBuilder_destroy_##type , \
+	&type##_DistributionDelegate , \
+	ekDistributionBuilder_requiredMemory_##type \
+};
+
+
+
+DECLARE_BUILDER(ekCSA)
+DECLARE_BUILDER(ekCMA)
+DECLARE_BUILDER(ekSepCMA)
+
+
+
+static const
+ekDistributionBuilder* ekDistributionBuildersList[] = 
+{
+	&ekCSA_DistributionBuilder,
+	&ekCMA_DistributionBuilder,
+	&ekSepCMA_DistributionBuilder,
+	NULL
+};
+
+
+
+const ekDistributionBuilder*
+ekDistributionBuilder_byName(const char* name) {
+	const ekDistributionBuilder** ret;
+
+	for(ret = ekDistributionBuildersList; (*ret) != NULL; ++ret) {
+		if (strcmp((*ret)->delegate->name, name) == 0)
+			break;
+	}
+
+	return (*ret);
+}
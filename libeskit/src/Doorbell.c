@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include "eskit/Doorbell.h"
+
+
+
+void
+ekDoorbell_init(ekDoorbell* self) {
+	pthread_mutexattr_t mutexAttr;
+	pthread_condattr_t condAttr;
+
+	pthread_mutexattr_init(&mutexAttr);
+	pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+	pthread_mutexattr_setrobust(&mutexAttr, PTHREAD_MUTEX_ROBUST);
+	pthread_mutex_init(&(self->mutex), &mutexAttr);
+	pthread_mutexattr_destroy(&mutexAttr);
+
+	pthread_condattr_init(&condAttr);
+	pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED);
+	pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+	pthread_cond_init(&(self->cond), &condAttr);
+	pthread_condattr_destroy(&condAttr);
+
+	self->count = 0;
+}
+
+
+
+void
+ekDoorbell_destroy(ekDoorbell* self) {
+	pthread_cond_destroy(&(self->cond));
+	pthread_mutex_destroy(&(self->mutex));
+}
+
+
+
+void
+ekDoorbell_lock(ekDoorbell* self) {
+	/* Recovers the mutex if its owner died while holding it */
+	if (pthread_mutex_lock(&(self->mutex)) == EOWNERDEAD)
+		pthread_mutex_consistent(&(self->mutex));
+}
+
+
+
+void
+ekDoorbell_unlock(ekDoorbell* self) {
+	pthread_mutex_unlock(&(self->mutex));
+}
+
+
+
+void
+ekDoorbell_ring(ekDoorbell* self) {
+	ekDoorbell_lock(self);
+	self->count += 1;
+	pthread_cond_broadcast(&(self->cond));
+	pthread_mutex_unlock(&(self->mutex));
+}
+
+
+
+uint32_t
+ekDoorbell_count(ekDoorbell* self) {
+	uint32_t ret;
+
+	ekDoorbell_lock(self);
+	ret = self->count;
+	pthread_mutex_unlock(&(self->mutex));
+
+	return ret;
+}
+
+
+
+uint32_t
+ekDoorbell_wait(ekDoorbell* self, uint32_t count, double timeout) {
+	int ret;
+	uint32_t current;
+	double seconds;
+	struct timespec deadline;
+
+	/* Absolute deadline on the monotonic clock */
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	if (timeout < HUGE_VAL) {
+		seconds = floor(timeout);
+		deadline.tv_sec += (time_t)seconds;
+		deadline.tv_nsec += (long)((timeout - seconds) * 1e9);
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec += 1;
+			deadline.tv_nsec -= 1000000000L;
+		}
+	}
+
+	ekDoorbell_lock(self);
+	while(self->count == count) {
+		if (timeout < HUGE_VAL)
+			ret = pthread_cond_timedwait(&(self->cond), &(self->mutex), &deadline);
+		else
+			ret = pthread_cond_wait(&(self->cond), &(self->mutex));
+
+		if (ret == EOWNERDEAD)
+			pthread_mutex_consistent(&(self->mutex));
+		else if (ret == ETIMEDOUT)
+			break;
+	}
+	current = self->count;
+	pthread_mutex_unlock(&(self->mutex));
+
+	return current;
+}
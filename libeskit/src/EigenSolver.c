@@ -11,18 +11,33 @@
 
 
 
+void
+ekEigenSolver_init(ekEigenSolver* self, size_t size) {
+	ekEigenSolver_initFromArena(self, size, NULL);
+}
+
+
+
 #ifdef USE_LAPACK
 /* --- LAPACK based implementation ----------------------------------------- */
 
 void
-ekEigenSolver_init(ekEigenSolver* self, size_t size) {
+ekEigenSolver_initFromArena(ekEigenSolver* self, size_t size, ekArena* arena) {
+	self->size = size;
 	self->JOBZ = 'V';
 	self->UPLO = 'U';
 	self->N = size;
 	self->LDA = size;
 	self->LWORK = size * size;
 
-	self->scratchMem = newArray(double, size * size);
+	self->scratchMem = ekArena_newArray(arena, double, size * size);
+}
+
+
+
+size_t
+ekEigenSolver_requiredMemory(size_t size) {
+	return size * size * sizeof(double);
 }
 
 
@@ -61,8 +76,16 @@ ekEigenSolver_solve(ekEigenSolver* self, const ekMatrix* M, ekMatrix* vectors, d
 /* --- Householder & QL based implementation ------------------------------- */
 
 void
-ekEigenSolver_init(ekEigenSolver* self, size_t size) {
-	self->scratchMem = newArray(double, size);
+ekEigenSolver_initFromArena(ekEigenSolver* self, size_t size, ekArena* arena) {
+	self->size = size;
+	self->scratchMem = ekArena_newArray(arena, double, size);
+}
+
+
+
+size_t
+ekEigenSolver_requiredMemory(size_t size) {
+	return size * sizeof(double);
 }
 
 
@@ -85,3 +108,16 @@ ekEigenSolver_solve(ekEigenSolver* self, const ekMatrix* M, ekMatrix* vectors, d
 
 #endif /* #ifdef USE_LAPACK */
 
+
+
+size_t
+ekEigenSolver_memoryUsage(const ekEigenSolver* self) {
+	return ekEigenSolver_requiredMemory(self->size);
+}
+
+
+
+size_t
+ekEigenSolver_arenaSize(size_t size) {
+	return ekArena_alignedSize(ekEigenSolver_requiredMemory(size));
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "eskit/Macros.h"
+#include "eskit/ArrayOps.h"
+#include "eskit/Checkpoint.h"
+#include "eskit/FitnessCache.h"
+
+
+
+#define ekFitnessCache_nil ((size_t)-1)
+
+#define ekFitnessCache_key(self, entry) ((self)->keys + (entry) * (self)->N)
+
+#define ESKIT_FITNESS_CACHE_MAGIC 0x4346456bu   /* "kEFC" when read on little endian */
+
+#define ESKIT_FITNESS_CACHE_VERSION 1u
+
+
+
+void
+ekFitnessCache_init(ekFitnessCache* self, size_t N, size_t capacity) {
+	self->N = N;
+	self->capacity = capacity;
+	self->quantum = 0.0;
+
+	self->keys = newArray(double, capacity * N);
+	self->fitnesses = newArray(double, capacity);
+	self->hashes = newArray(uint64_t, capacity);
+	self->older = newArray(size_t, capacity);
+	self->newer = newArray(size_t, capacity);
+	self->chain = newArray(size_t, capacity);
+
+	/* Power of two number of buckets, with a load factor bellow 0.5 */
+	for(self->nbBuckets = 16; self->nbBuckets < 2 * capacity; self->nbBuckets *= 2);
+	self->buckets = newArray(size_t, self->nbBuckets);
+
+	self->tmpKey = newArray(double, N);
+
+	ekFitnessCache_clear(self);
+}
+
+
+
+void
+ekFitnessCache_destroy(ekFitnessCache* self) {
+	free(self->keys);
+	free(self->fitnesses);
+	free(self->hashes);
+	free(self->older);
+	free(self->newer);
+	free(self->chain);
+	free(self->buckets);
+	free(self->tmpKey);
+}
+
+
+
+void
+ekFitnessCache_setQuantum(ekFitnessCache* self, double quantum) {
+	self->quantum = quantum;
+}
+
+
+
+void
+ekFitnessCache_clear(ekFitnessCache* self) {
+	size_t i;
+
+	for(i = 0; i < self->nbBuckets; ++i)
+		self->buckets[i] = ekFitnessCache_nil;
+
+	self->nbEntries = 0;
+	self->mostRecent = ekFitnessCache_nil;
+	self->leastRecent = ekFitnessCache_nil;
+	self->nbHits = 0;
+	self->nbMisses = 0;
+}
+
+
+
+/* --- Keys ---------------------------------------------------------------- */
+
+static void
+ekFitnessCache_computeKey(const ekFitnessCache* self, const double* x, double* key) {
+	size_t i;
+
+	for(i = 0; i < self->N; ++i) {
+		key[i] = (self->quantum > 0.0) ? floor(x[i] / self->quantum + 0.5) : x[i];
+
+		/* -0.0 and 0.0 should be the same key */
+		if (key[i] == 0.0)
+			key[i] = 0.0;
+	}
+}
+
+
+
+/* FNV-1a hash of the key bytes */
+static uint64_t
+ekFitnessCache_hash(const ekFitnessCache* self, const double* key) {
+	size_t i;
+	uint64_t ret;
+	const unsigned char* bytes;
+
+	bytes = (const unsigned char*)key;
+	ret = 14695981039346656037ull;
+	for(i = self->N * sizeof(double); i != 0; --i, ++bytes) {
+		ret ^= *bytes;
+		ret *= 1099511628211ull;
+	}
+
+	return ret;
+}
+
+
+
+static size_t
+ekFitnessCache_find(const ekFitnessCache* self, const double* key, uint64_t hash) {
+	size_t entry;
+
+	entry = self->buckets[hash & (self->nbBuckets - 1)];
+	for( ; entry != ekFitnessCache_nil; entry = self->chain[entry])
+		if ((self->hashes[entry] == hash) && (memcmp(ekFitnessCache_key(self, entry), key, self->N * sizeof(double)) == 0))
+			break;
+
+	return entry;
+}
+
+
+
+/* --- Recently used list -------------------------------------------------- */
+
+static void
+ekFitnessCache_unlink(ekFitnessCache* self, size_t entry) {
+	if (self->newer[entry] != ekFitnessCache_nil)
+		self->older[self->newer[entry]] = self->older[entry];
+	else
+		self->mostRecent = self->older[entry];
+
+	if (self->older[entry] != ekFitnessCache_nil)
+		self->newer[self->older[entry]] = self->newer[entry];
+	else
+		self->leastRecent = self->newer[entry];
+}
+
+
+
+static void
+ekFitnessCache_pushMostRecent(ekFitnessCache* self, size_t entry) {
+	self->older[entry] = self->mostRecent;
+	self->newer[entry] = ekFitnessCache_nil;
+
+	if (self->mostRecent != ekFitnessCache_nil)
+		self->newer[self->mostRecent] = entry;
+	else
+		self->leastRecent = entry;
+
+	self->mostRecent = entry;
+}
+
+
+
+static void
+ekFitnessCache_removeFromBucket(ekFitnessCache* self, size_t entry) {
+	size_t* link;
+
+	link = self->buckets + (self->hashes[entry] & (self->nbBuckets - 1));
+	while(*link != entry)
+		link = self->chain + (*link);
+
+	*link = self->chain[entry];
+}
+
+
+
+static void
+ekFitnessCache_insertKey(ekFitnessCache* self, const double* key, double fitness) {
+	size_t entry, bucket;
+	uint64_t hash;
+
+	if (self->capacity == 0)
+		return;
+
+	/* Known key, just refresh it */
+	hash = ekFitnessCache_hash(self, key);
+	entry = ekFitnessCache_find(self, key, hash);
+	if (entry != ekFitnessCache_nil) {
+		self->fitnesses[entry] = fitness;
+		ekFitnessCache_unlink(self, entry);
+		ekFitnessCache_pushMostRecent(self, entry);
+		return;
+	}
+
+	/* Pick a free entry, or recycle the least recently used one */
+	if (self->nbEntries < self->capacity) {
+		entry = self->nbEntries;
+		self->nbEntries += 1;
+	}
+	else {
+		entry = self->leastRecent;
+		ekFitnessCache_unlink(self, entry);
+		ekFitnessCache_removeFromBucket(self, entry);
+	}
+
+	ekArrayOpsD_copy(ekFitnessCache_key(self, entry), key, self->N);
+	self->hashes[entry] = hash;
+	self->fitnesses[entry] = fitness;
+
+	bucket = hash & (self->nbBuckets - 1);
+	self->chain[entry] = self->buckets[bucket];
+	self->buckets[bucket] = entry;
+
+	ekFitnessCache_pushMostRecent(self, entry);
+}
+
+
+
+/* --- Public interface ---------------------------------------------------- */
+
+int
+ekFitnessCache_lookup(ekFitnessCache* self, const double* x, double* fitness) {
+	size_t entry;
+
+	ekFitnessCache_computeKey(self, x, self->tmpKey);
+	entry = ekFitnessCache_find(self, self->tmpKey, ekFitnessCache_hash(self, self->tmpKey));
+
+	if (entry == ekFitnessCache_nil) {
+		self->nbMisses += 1;
+		return 0;
+	}
+
+	self->nbHits += 1;
+	*fitness = self->fitnesses[entry];
+	ekFitnessCache_unlink(self, entry);
+	ekFitnessCache_pushMostRecent(self, entry);
+
+	return 1;
+}
+
+
+
+void
+ekFitnessCache_insert(ekFitnessCache* self, const double* x, double fitness) {
+	ekFitnessCache_computeKey(self, x, self->tmpKey);
+	ekFitnessCache_insertKey(self, self->tmpKey, fitness);
+}
+
+
+
+double
+ekFitnessCache_hitRate(const ekFitnessCache* self) {
+	size_t nbLookups;
+
+	nbLookups = self->nbHits + self->nbMisses;
+	if (nbLookups == 0)
+		return 0.0;
+
+	return ((double)self->nbHits) / nbLookups;
+}
+
+
+
+int
+ekFitnessCache_save(const ekFitnessCache* self, FILE* file) {
+	size_t entry;
+	uint32_t header[2];
+
+	header[0] = ESKIT_FITNESS_CACHE_MAGIC;
+	header[1] = ESKIT_FITNESS_CACHE_VERSION;
+
+	if (!(ekCheckpoint_write(file, header, sizeof(header)) &&
+	      ekCheckpoint_writeSize(file, self->N) &&
+	      ekCheckpoint_writeDouble(file, self->quantum) &&
+	      ekCheckpoint_writeSize(file, self->nbEntries)))
+		return 0;
+
+	/* From the least to the most recently used, to keep the order on loading */
+	for(entry = self->leastRecent; entry != ekFitnessCache_nil; entry = self->newer[entry])
+		if (!(ekCheckpoint_writeArray(file, ekFitnessCache_key(self, entry), self->N) &&
+		      ekCheckpoint_writeDouble(file, self->fitnesses[entry])))
+			return 0;
+
+	return fflush(file) == 0;
+}
+
+
+
+int
+ekFitnessCache_load(ekFitnessCache* self, FILE* file) {
+	size_t i, N, nbEntries;
+	uint32_t header[2];
+	double quantum, fitness;
+
+	if (!ekCheckpoint_read(file, header, sizeof(header)))
+		return 0;
+
+	if ((header[0] != ESKIT_FITNESS_CACHE_MAGIC) || (header[1] != ESKIT_FITNESS_CACHE_VERSION))
+		return 0;
+
+	if (!(ekCheckpoint_readSize(file, &N) &&
+	      ekCheckpoint_readDouble(file, &quantum) &&
+	      ekCheckpoint_readSize(file, &nbEntries)))
+		return 0;
+
+	/* Keys are only comparable with the same dimension and quantization */
+	if ((N != self->N) || (quantum != self->quantum))
+		return 0;
+
+	for(i = 0; i < nbEntries; ++i) {
+		if (!(ekCheckpoint_readArray(file, self->tmpKey, N) &&
+		      ekCheckpoint_readDouble(file, &fitness)))
+			return 0;
+
+		ekFitnessCache_insertKey(self, self->tmpKey, fitness);
+	}
+
+	return 1;
+}
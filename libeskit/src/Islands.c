@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdlib.h>
+#include "eskit/Macros.h"
+#include "eskit/ArrayOps.h"
+#include "eskit/Optimizer.h"
+#include "eskit/Islands.h"
+
+
+
+/* Keeps the counters written by different threads on different cache lines */
+#define ekIslands_cacheLineSize 64
+
+
+
+struct s_ekIsland {
+	/* Mailbox, written by the previous island of the ring */
+	size_t head ESKIT_ALIGNED(ekIslands_cacheLineSize);
+	char headPadding[ekIslands_cacheLineSize - sizeof(size_t)];
+	double* migrants;
+	double fitnesses[ESKIT_ISLANDS_MAILBOX_SIZE];
+
+	/* Mailbox, written by the island itself */
+	size_t tail ESKIT_ALIGNED(ekIslands_cacheLineSize);
+	char tailPadding[ekIslands_cacheLineSize - sizeof(size_t)];
+
+	size_t id;
+	uint32_t seed;
+	int running;
+	ekOptimizer optim;
+	ekDistribution distrib;
+
+	size_t maxEvaluations;
+	size_t nbEvaluations;
+	size_t nbGenerations;
+	size_t nbMigrations;
+	size_t nbDropped;
+	size_t nbRestarts;
+	double* bestX;
+	double bestFitness;
+};
+
+
+
+void
+ekIslands_init(ekIslands* self, size_t N, size_t nbIslands, const ekDistributionBuilder* builder) {
+	size_t i;
+
+	if (nbIslands == 0)
+		nbIslands = 1;
+
+	self->N = N;
+	self->nbIslands = nbIslands;
+	self->builder = builder;
+
+	self->sigmaInit = 1.0;
+	self->sigmaStop = 10e-12;
+	self->lambda = 0;
+
+	self->xMeanInit = newArray(double, N);
+	ekArrayOpsD_fill(self->xMeanInit, N, 0.0);
+
+	self->migrationPeriod = 10;
+	self->nbMigrants = 1;
+
+	self->maxEvaluations = 1000 * N * N;
+	self->targetFitness = -HUGE_VAL;
+
+	self->threadPool = NULL;
+	ekRandomizer_init(&(self->randomizer), ekRandomizerSize_1024);
+	ekRandomizer_seed(&(self->randomizer), 42);
+
+	/* On cache lines of their own, as the padding of the counters assumes */
+	if (posix_memalign((void**)&(self->islands), ekIslands_cacheLineSize, nbIslands * sizeof(struct s_ekIsland)) != 0)
+		self->islands = NULL;
+	for(i = 0; i < nbIslands; ++i) {
+		self->islands[i].id = i;
+		self->islands[i].migrants = newArray(double, ESKIT_ISLANDS_MAILBOX_SIZE * N);
+		self->islands[i].bestX = newArray(double, N);
+	}
+
+	self->bestX = newArray(double, N);
+	self->bestFitness = HUGE_VAL;
+	self->nbEvaluations = 0;
+	self->nbMigrations = 0;
+	self->nbDropped = 0;
+	self->nbRestarts = 0;
+}
+
+
+
+void
+ekIslands_destroy(ekIslands* self) {
+	size_t i;
+
+	for(i = 0; i < self->nbIslands; ++i) {
+		free(self->islands[i].migrants);
+		free(self->islands[i].bestX);
+	}
+
+	free(self->islands);
+	free(self->xMeanInit);
+	free(self->bestX);
+
+	ekRandomizer_destroy(&(self->randomizer));
+}
+
+
+
+void
+ekIslands_setSigma(ekIslands* self, double sigmaInit, double sigmaStop) {
+	self->sigmaInit = sigmaInit;
+	self->sigmaStop = sigmaStop;
+}
+
+
+
+void
+ekIslands_setLambda(ekIslands* self, size_t lambda) {
+	self->lambda = lambda;
+}
+
+
+
+void
+ekIslands_setMigration(ekIslands* self, size_t period, size_t nbMigrants) {
+	self->migrationPeriod = (period > 0) ? period : 1;
+	self->nbMigrants = nbMigrants;
+}
+
+
+
+void
+ekIslands_setBudget(ekIslands* self, size_t maxEvaluations) {
+	self->maxEvaluations = maxEvaluations;
+}
+
+
+
+void
+ekIslands_setTargetFitness(ekIslands* self, double targetFitness) {
+	self->targetFitness = targetFitness;
+}
+
+
+
+void
+ekIslands_setThreadPool(ekIslands* self, ekThreadPool* pool) {
+	self->threadPool = pool;
+}
+
+
+
+/* --- Migration ----------------------------------------------------------- */
+
+/* Called by the previous island only */
+static void
+ekIslands_send(ekIslands* self, struct s_ekIsland* from, struct s_ekIsland* to) {
+	size_t i, head, tail, slot;
+	const ekPoint* point;
+
+	for(i = 0; (i < self->nbMigrants) && (i < ekOptimizer_lambda(&(from->optim))); ++i) {
+		head = __atomic_load_n(&(to->head), __ATOMIC_RELAXED);
+		tail = __atomic_load_n(&(to->tail), __ATOMIC_ACQUIRE);
+
+		/* The island is late, the oldest migrants are still waiting */
+		if (head - tail == ESKIT_ISLANDS_MAILBOX_SIZE) {
+			from->nbDropped += 1;
+			continue;
+		}
+
+		point = &ekOptimizer_point(&(from->optim), i);
+		slot = head % ESKIT_ISLANDS_MAILBOX_SIZE;
+		ekArrayOpsD_copy(to->migrants + slot * self->N, point->x, self->N);
+		to->fitnesses[slot] = point->fitness;
+
+		__atomic_store_n(&(to->head), head + 1, __ATOMIC_RELEASE);
+	}
+}
+
+
+
+/* Injects the migrants received since the last generation */
+static void
+ekIslands_receive(ekIslands* self, struct s_ekIsland* island) {
+	size_t head, tail, slot;
+
+	tail = __atomic_load_n(&(island->tail), __ATOMIC_RELAXED);
+	head = __atomic_load_n(&(island->head), __ATOMIC_ACQUIRE);
+
+	for(; tail != head; ++tail) {
+		slot = tail % ESKIT_ISLANDS_MAILBOX_SIZE;
+		island->nbMigrations += ekOptimizer_injectPoint(&(island->optim), island->migrants + slot * self->N, island->fitnesses[slot]);
+	}
+
+	__atomic_store_n(&(island->tail), tail, __ATOMIC_RELEASE);
+}
+
+
+
+/* --- Islands ------------------------------------------------------------- */
+
+/* Starts a run of the island optimizer with a fresh distribution */
+static void
+ekIslands_startRun(ekIslands* self, struct s_ekIsland* island) {
+	ekDistribution_initFromBuilder(&(island->distrib), self->builder, self->N, self->sigmaInit, self->sigmaStop);
+	ekOptimizer_setDistribution(&(island->optim), &(island->distrib));
+
+	ekArrayOpsD_copy(ekOptimizer_xMean(&(island->optim)), self->xMeanInit, self->N);
+	ekOptimizer_start(&(island->optim));
+}
+
+
+
+/* Keeps the best point of the island over its runs */
+static void
+ekIslands_keepBest(ekIslands* self, struct s_ekIsland* island) {
+	/* No best point without a single update */
+	if ((ekOptimizer_nbUpdates(&(island->optim)) > 0) && (ekOptimizer_bestPoint(&(island->optim)).fitness < island->bestFitness)) {
+		island->bestFitness = ekOptimizer_bestPoint(&(island->optim)).fitness;
+		ekArrayOpsD_copy(island->bestX, ekOptimizer_bestPoint(&(island->optim)).x, self->N);
+	}
+}
+
+
+
+static void
+ekIslands_start(ekIslands* self, struct s_ekIsland* island) {
+	ekOptimizer_init(&(island->optim), self->N);
+
+	if (self->lambda > 0)
+		ekOptimizer_setMuLambda(&(island->optim), self->lambda / 2, self->lambda);
+
+	ekRandomizer_seed(ekOptimizer_getRandomizer(&(island->optim)), island->seed);
+	ekIslands_startRun(self, island);
+
+	island->running = 1;
+}
+
+
+
+/* Runs one generation, returns 0 once the island is done */
+static int
+ekIslands_step(ekIslands* self, struct s_ekIsland* island, double(*function)(const double*, size_t)) {
+	ekOptimizer* optim;
+
+	optim = &(island->optim);
+
+	if ((__atomic_load_n(&(self->done), __ATOMIC_RELAXED)) || (island->nbEvaluations + ekOptimizer_lambda(optim) > island->maxEvaluations)) {
+		island->running = 0;
+		return 0;
+	}
+
+	ekOptimizer_sampleCloud(optim);
+	ekOptimizer_evaluateFunction(optim, function);
+	ekIslands_receive(self, island);
+	ekOptimizer_update(optim);
+
+	island->nbEvaluations += ekOptimizer_lambda(optim);
+	island->nbGenerations += 1;
+
+	if ((self->nbIslands > 1) && (island->nbGenerations % self->migrationPeriod == 0))
+		ekIslands_send(self, island, self->islands + (island->id + 1) % self->nbIslands);
+
+	if (ekOptimizer_bestPoint(optim).fitness <= self->targetFitness)
+		__atomic_store_n(&(self->done), 1, __ATOMIC_RELAXED);
+
+	/*
+	   A stopped island would not drain its mailbox anymore, breaking the
+	   ring : it restarts instead, until its budget is spent.
+	 */
+	if (ekOptimizer_stop(optim) != ekStopCriterionId_None) {
+		ekIslands_keepBest(self, island);
+		ekDistribution_destroy(&(island->distrib), self->builder);
+		ekIslands_startRun(self, island);
+		island->nbRestarts += 1;
+	}
+
+	return island->running;
+}
+
+
+
+static void
+ekIslands_stop(ekIslands* self, struct s_ekIsland* island) {
+	ekIslands_keepBest(self, island);
+
+	ekOptimizer_destroy(&(island->optim));
+	ekDistribution_destroy(&(island->distrib), self->builder);
+}
+
+
+
+typedef struct {
+	ekIslands* islands;
+	double(*function)(const double*, size_t);
+} ekIslandsJob;
+
+
+
+static void
+ekIslands_worker(void* data, size_t taskId, size_t ESKIT_UNUSED(workerId)) {
+	ekIslandsJob* job;
+	struct s_ekIsland* island;
+
+	job = (ekIslandsJob*)data;
+	island = job->islands->islands + taskId;
+
+	ekIslands_start(job->islands, island);
+	while(ekIslands_step(job->islands, island, job->function));
+	ekIslands_stop(job->islands, island);
+}
+
+
+
+void
+ekIslands_run(ekIslands* self, double(*function)(const double*, size_t)) {
+	int running;
+	size_t i;
+	struct s_ekIsland* island;
+	ekIslandsJob job;
+
+	self->done = 0;
+	for(i = 0; i < self->nbIslands; ++i) {
+		island = self->islands + i;
+		island->head = 0;
+		island->tail = 0;
+		island->seed = ekRandomizer_next(&(self->randomizer));
+		island->maxEvaluations = self->maxEvaluations / self->nbIslands;
+		island->nbEvaluations = 0;
+		island->nbGenerations = 0;
+		island->nbMigrations = 0;
+		island->nbDropped = 0;
+		island->nbRestarts = 0;
+		island->bestFitness = HUGE_VAL;
+	}
+
+	job.islands = self;
+	job.function = function;
+
+	if (self->threadPool != NULL)
+		ekThreadPool_run(self->threadPool, ekIslands_worker, &job, self->nbIslands);
+	else {
+		/* The islands take turns, one generation each */
+		for(i = 0; i < self->nbIslands; ++i)
+			ekIslands_start(self, self->islands + i);
+
+		do {
+			running = 0;
+			for(i = 0; i < self->nbIslands; ++i)
+				if (self->islands[i].running)
+					running |= ekIslands_step(self, self->islands + i, function);
+		} while(running);
+
+		for(i = 0; i < self->nbIslands; ++i)
+			ekIslands_stop(self, self->islands + i);
+	}
+
+	/* Gather the results */
+	self->bestFitness = HUGE_VAL;
+	self->nbEvaluations = 0;
+	self->nbMigrations = 0;
+	self->nbDropped = 0;
+	self->nbRestarts = 0;
+	for(i = 0; i < self->nbIslands; ++i) {
+		island = self->islands + i;
+		self->nbEvaluations += island->nbEvaluations;
+		self->nbMigrations += island->nbMigrations;
+		self->nbDropped += island->nbDropped;
+		self->nbRestarts += island->nbRestarts;
+
+		if (island->bestFitness < self->bestFitness) {
+			self->bestFitness = island->bestFitness;
+			ekArrayOpsD_copy(self->bestX, island->bestX, self->N);
+		}
+	}
+}
@@ -10,11 +10,111 @@
 #include "eskit/Macros.h"
 #include "eskit/Matrix.h"
 #include "eskit/ArrayOps.h"
+#include "eskit/ThreadPool.h"
+
+
+
+/* Number of rows processed at once by a worker, for row partitioned kernels */
+#define ekMatrix_rowBlockSize 256
+
+
+
+/* Matrices with at least that number of elements are processed in parallel */
+static size_t ekMatrix_parallelThresholdValue = 1000 * 1000;
+
+
+
+void
+ekMatrix_setParallelThreshold(size_t nbElements) {
+	ekMatrix_parallelThresholdValue = nbElements;
+}
+
+
+
+size_t
+ekMatrix_parallelThreshold(void) {
+	return ekMatrix_parallelThresholdValue;
+}
+
+
+
+#ifdef USE_OPENMP
+/* --- OpenMP based kernels ------------------------------------------------ */
+
+/*
+   Inside a thread pool task, the other workers are busy as well : an OpenMP
+   team per worker would oversubscribe the cores
+ */
+#define ekMatrix_isLarge(self) (((self)->tupleSize >= ekMatrix_parallelThresholdValue) && !ekThreadPool_inTask())
+
+
+
+static void
+ekMatrix_parallel_scalarMul(ekMatrix* self, double alpha) {
+	size_t i;
+
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < self->nbCols; ++i)
+		ekArrayOpsD_scalarMul(self->cols[i], self->nbRows, alpha);
+}
+
+
+
+static void
+ekMatrix_parallel_incMulCross(ekMatrix* self, const double* u, double alpha) {
+	size_t i;
+
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < self->nbCols; ++i)
+		ekArrayOpsD_incMul(self->cols[i], u, self->nbCols, alpha * u[i]);
+}
+
+
+
+/* Each worker handles a block of rows, summing the columns in the same order as the sequential version */
+static void
+ekMatrix_parallel_vectorProd(ekMatrix* self, const double* u, double* v) {
+	size_t i, j, nbBlocks, offset, size;
+
+	nbBlocks = (self->nbRows + ekMatrix_rowBlockSize - 1) / ekMatrix_rowBlockSize;
+
+	#pragma omp parallel for private(j, offset, size) schedule(static)
+	for(i = 0; i < nbBlocks; ++i) {
+		offset = i * ekMatrix_rowBlockSize;
+		size = self->nbRows - offset;
+		if (size > ekMatrix_rowBlockSize)
+			size = ekMatrix_rowBlockSize;
+
+		ekArrayOpsD_copyMul(v + offset, self->cols[0] + offset, size, u[0]);
+		for(j = 1; j < self->nbCols; ++j)
+			ekArrayOpsD_incMul(v + offset, self->cols[j] + offset, size, u[j]);
+	}
+}
+
+
+
+static void
+ekMatrix_parallel_diagProd(ekMatrix* self, const double* u, ekMatrix* v) {
+	size_t i;
+
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < self->nbCols; ++i)
+		ekArrayOpsD_copyMul(v->cols[i], self->cols[i], self->nbRows, u[i]);
+}
+
+#endif /* #ifdef USE_OPENMP */
 
 
 
 void
 ekMatrix_init(ekMatrix* self, size_t nbCols, size_t nbRows) {
+	ekMatrix_initFromArena(self, nbCols, nbRows, NULL);
+}
+
+
+
+void
+ekMatrix_initFromArena(ekMatrix* self, size_t nbCols, size_t nbRows, ekArena* arena) {
 	size_t i;
 	double* offset;
 
@@ -22,8 +122,8 @@ ekMatrix_init(ekMatrix* self, size_t nbCols, size_t nbRows) {
 	self->nbRows = nbRows;
 	self->tupleSize = nbCols * nbRows;
 
-	self->cols = newArray(double*, nbCols);
-	self->tuple = newArray(double, self->tupleSize);
+	self->cols = ekArena_newArray(arena, double*, nbCols);
+	self->tuple = ekArena_newArray(arena, double, self->tupleSize);
 	
 	offset = self->tuple;
 	for(i = 0; i < nbCols; ++i, offset += nbRows)
@@ -40,6 +140,29 @@ ekMatrix_destroy(ekMatrix* self) {
 
 
 
+size_t
+ekMatrix_requiredMemory(size_t nbCols, size_t nbRows) {
+	return nbCols * sizeof(double*) + nbCols * nbRows * sizeof(double);
+}
+
+
+
+size_t
+ekMatrix_memoryUsage(const ekMatrix* self) {
+	return ekMatrix_requiredMemory(self->nbCols, self->nbRows);
+}
+
+
+
+size_t
+ekMatrix_arenaSize(size_t nbCols, size_t nbRows) {
+	return
+		ekArena_alignedSize(nbCols * sizeof(double*)) +
+		ekArena_alignedSize(nbCols * nbRows * sizeof(double));
+}
+
+
+
 void
 ekMatrix_copy(ekMatrix* self, const ekMatrix* u) {
 	ekArrayOpsD_copy(self->tuple, u->tuple, self->tupleSize);
@@ -63,6 +186,13 @@ ekMatrix_fill(ekMatrix* self, double alpha) {
 
 void
 ekMatrix_scalarMul(ekMatrix* self, double alpha) {
+#ifdef USE_OPENMP
+	if (ekMatrix_isLarge(self)) {
+		ekMatrix_parallel_scalarMul(self, alpha);
+		return;
+	}
+#endif
+
 	ekArrayOpsD_scalarMul(self->tuple, self->tupleSize, alpha);
 }
 
@@ -114,6 +244,13 @@ ekMatrix_incMulCross(ekMatrix* self, const double* u, double alpha) {
 	double* col;
 	const double* uT;
 
+#ifdef USE_OPENMP
+	if (ekMatrix_isLarge(self)) {
+		ekMatrix_parallel_incMulCross(self, u, alpha);
+		return;
+	}
+#endif
+
 	uT = u;
 	col = self->tuple;
 	for(i = self->nbCols; i != 0; --i, ++u, col += self->nbCols)
@@ -127,6 +264,13 @@ ekMatrix_vectorProd(ekMatrix* self, const double* u, double* v) {
 	size_t i;
 	double* col;
 
+#ifdef USE_OPENMP
+	if (ekMatrix_isLarge(self)) {
+		ekMatrix_parallel_vectorProd(self, u, v);
+		return;
+	}
+#endif
+
 	col = self->tuple;
 	ekArrayOpsD_copyMul(v, col, self->nbRows, *u);
 
@@ -142,6 +286,13 @@ void
 ekMatrix_diagProd(ekMatrix* self, const double* u, ekMatrix* v) {
 	size_t i;
 
+#ifdef USE_OPENMP
+	if (ekMatrix_isLarge(self)) {
+		ekMatrix_parallel_diagProd(self, u, v);
+		return;
+	}
+#endif
+
 	for(i = 0; i < self->nbCols; ++i)
 		ekArrayOpsD_copyMul(v->cols[i], self->cols[i], self->nbRows, u[i]);
 }
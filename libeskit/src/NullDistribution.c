@@ -49,6 +49,36 @@ ekNullDistribution_delegate_stop(ekDistribution* ESKIT_UNUSED(self), ekOptimizer
 
 
 
+static int
+ekNullDistribution_delegate_save(ekDistribution* ESKIT_UNUSED(self), ekOptimizer* ESKIT_UNUSED(optim), FILE* ESKIT_UNUSED(file)) {
+	return 1;
+}
+
+
+
+static int
+ekNullDistribution_delegate_load(ekDistribution* ESKIT_UNUSED(self), ekOptimizer* ESKIT_UNUSED(optim), FILE* ESKIT_UNUSED(file)) {
+	return 1;
+}
+
+
+
+static void
+ekNullDistribution_delegate_view(ekDistribution* ESKIT_UNUSED(self), ekOptimizer* ESKIT_UNUSED(optim), ekGenerationView* view) {
+	view->sigma = 0.0;
+	view->DMin = 1.0;
+	view->DMax = 1.0;
+}
+
+
+
+static void
+ekNullDistribution_delegate_project(ekDistribution* ESKIT_UNUSED(self), ekOptimizer* optim, const double* ESKIT_UNUSED(x), double* z) {
+	ekArrayOpsD_fill(z, ekOptimizer_N(optim), 0.0);
+}
+
+
+
 const ekDistributionDelegate 
 ekNullDistribution_DistributionDelegate =
 {
@@ -57,5 +87,9 @@ ekNullDistribution_DistributionDelegate =
 	ekNullDistribution_delegate_update,
 	ekNullDistribution_delegate_samplePoint,
 	ekNullDistribution_delegate_sampleCloud,
-	ekNullDistribution_delegate_stop
+	ekNullDistribution_delegate_stop,
+	ekNullDistribution_delegate_save,
+	ekNullDistribution_delegate_load,
+	ekNullDistribution_delegate_view,
+	ekNullDistribution_delegate_project
 };
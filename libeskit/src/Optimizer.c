@@ -14,12 +14,27 @@
 #include "eskit/MeanWeights.h"
 #include "eskit/Distribution.h"
 #include "eskit/NullDistribution.h"
+#include "eskit/Checkpoint.h"
+#include "eskit/Clock.h"
+
+
+
+/* Target duration of a chunk of points evaluated in parallel, in seconds */
+#define ESKIT_EVALUATION_CHUNK_DURATION 1e-4
+
+/* Largest norm of the z of an injected point, as advised by N. Hansen */
+#define ekOptimizer_injectionMaxNorm(N) (sqrt((double)(N)) + 2.0 * (N) / ((N) + 2.0))
 
 
 
 static void
 ekOptimizer_cleanup(ekOptimizer* self) {
+	/* Arena memory is released by its owner */
+	if (self->arena != NULL)
+		return;
+
 	free(self->meanWeights);
+	free(self->racingFitnesses);
 	free(self->pointArray);
 	free(self->points);
 	ekMatrix_destroy(&(self->X));
@@ -28,28 +43,184 @@ ekOptimizer_cleanup(ekOptimizer* self) {
 
 
 
+static void
+ekOptimizer_releaseBlockRandomizers(ekOptimizer* self) {
+	size_t i;
+
+	/* Carved once for all from an arena, with room for ESKIT_ARENA_BLOCKS workers */
+	if (self->arena != NULL) {
+		self->nbBlocks = 0;
+		return;
+	}
+
+	for(i = 0; i < self->nbBlocks; ++i)
+		ekRandomizer_destroy(self->blockRandomizers + i);
+
+	free(self->blockRandomizers);
+	self->blockRandomizers = NULL;
+	self->nbBlocks = 0;
+}
+
+
+
+static void
+ekOptimizer_releasePointRandomizers(ekOptimizer* self) {
+	size_t i;
+
+	/* Carved once for all from an arena */
+	if (self->arena != NULL)
+		return;
+
+	for(i = 0; i < self->nbPointRandomizers; ++i)
+		ekRandomizer_destroy(self->pointRandomizers + i);
+
+	free(self->pointRandomizers);
+	self->pointRandomizers = NULL;
+	self->nbPointRandomizers = 0;
+}
+
+
+
+/* One small random stream per point, reseeded at each sampling */
+static void
+ekOptimizer_setupPointRandomizers(ekOptimizer* self) {
+	size_t i;
+
+	ekOptimizer_releasePointRandomizers(self);
+
+	self->nbPointRandomizers = self->nbPointsMax;
+	self->pointRandomizers = ekArena_newArray(self->arena, ekRandomizer, self->nbPointRandomizers);
+	for(i = 0; i < self->nbPointRandomizers; ++i)
+		ekRandomizer_initFromArena(self->pointRandomizers + i, ekRandomizerSize_8, self->arena);
+}
+
+
+
+static void
+ekOptimizer_releaseCoords(ekOptimizer* self) {
+	/* Carved once for all from an arena */
+	if (self->arena != NULL)
+		return;
+
+	free(self->coordsMemory);
+	self->coordsMemory = NULL;
+}
+
+
+
+/* Size of a block holding the coordinate-major points, for a population size */
+static size_t
+ekOptimizer_coordsMemory(size_t N, size_t popSize) {
+	size_t nbRows;
+
+	nbRows = ((popSize + ESKIT_POINT_LANES - 1) / ESKIT_POINT_LANES) * ESKIT_POINT_LANES;
+	return
+		ESKIT_ARENA_ALIGNMENT - 1 +
+		ekMatrix_arenaSize(N, nbRows) +
+		ekArena_alignedSize(nbRows * sizeof(double));
+}
+
+
+
+/* Allocates the coordinate-major points in a single aligned block, once */
+static void
+ekOptimizer_setupCoords(ekOptimizer* self) {
+	size_t nbRows, size;
+	ekArena arena;
+
+	nbRows = ((self->nbPointsMax + ESKIT_POINT_LANES - 1) / ESKIT_POINT_LANES) * ESKIT_POINT_LANES;
+	if ((self->coordsMemory != NULL) && (ekMatrix_nbRows(&(self->coords)) == nbRows))
+		return;
+
+	ekOptimizer_releaseCoords(self);
+
+	size = ekOptimizer_coordsMemory(self->N, self->nbPointsMax);
+	self->coordsMemory = ekArena_alloc(self->arena, size);
+	ekArena_init(&arena, self->coordsMemory, size);
+	ekMatrix_initFromArena(&(self->coords), self->N, nbRows, &arena);
+	self->coordsFitnesses = ekArena_newArray(&arena, double, nbRows);
+}
+
+
+
 static void
 ekOptimizer_setup(ekOptimizer* self, size_t popSize) {
 	size_t i;
 	ekPoint* point;
 
 	/* Allocation for mean weights */
-	self->meanWeights    = newArray(double, popSize);
+	self->meanWeights    = ekArena_newArray(self->arena, double, popSize);
+	self->racingFitnesses = ekArena_newArray(self->arena, double, popSize);
 
 	/* Allocation for the points population */
-	self->pointArray     = newArray(ekPoint, popSize);
-	self->points         = newArray(ekPoint*, popSize);
-	ekMatrix_init(&(self->X), popSize, self->N);
-	ekMatrix_init(&(self->Z), popSize, self->N);
+	self->pointArray     = ekArena_newArray(self->arena, ekPoint, popSize);
+	self->points         = ekArena_newArray(self->arena, ekPoint*, popSize);
+	ekMatrix_initFromArena(&(self->X), popSize, self->N, self->arena);
+	ekMatrix_initFromArena(&(self->Z), popSize, self->N, self->arena);
 
 	point = self->pointArray;
 	for(i = 0; i < popSize; ++i, ++point) {
 		self->points[i] = point;
 		point->x = ekMatrix_col(&(self->X), i);
 		point->z = ekMatrix_col(&(self->Z), i);
+		point->aborted = 0;
 	}
 
 	self->nbPointsMax = popSize;
+
+	/* Every path growing the population, start or load, comes through here */
+	if (self->deterministic && (self->nbPointRandomizers < self->nbPointsMax))
+		ekOptimizer_setupPointRandomizers(self);
+}
+
+
+
+/* Points ranked in sampling order, undoing the sort of the last update */
+static void
+ekOptimizer_resetPoints(ekOptimizer* self) {
+	size_t i;
+
+	for(i = 0; (i < self->lambda) && (i < self->nbPointsMax); ++i)
+		self->points[i] = self->pointArray + i;
+}
+
+
+
+/* Settings of a freshly initialized optimizer, which do not allocate */
+static void
+ekOptimizer_setDefaults(ekOptimizer* self) {
+	self->bestPoint.aborted = 0;
+	self->nbAborted = 0;
+
+	/* Default setting for mean weights */
+	self->meanWeightsGen = &ekLog_MeanWeightsGenerator;
+	self->meanWeightsSetupDone = 0;
+
+	/* Sequential sampling by default */
+	self->threadPool = NULL;
+	self->evaluationCost = 0.0;
+	self->deterministic = 0;
+	self->started = 0;
+
+	/* No fitness cache by default */
+	self->fitnessCache = NULL;
+	self->nbCacheHits = 0;
+
+	/* No evaluation budget nor deadline by default */
+	self->nbEvaluations = 0;
+	self->maxEvaluations = 0;
+	self->deadline = HUGE_VAL;
+	self->lastUpdateTime = 0.0;
+	self->pointCost = 0.0;
+	self->lambdaShrinking = 0;
+
+	ekProfile_reset(&(self->profile));
+
+	/* No tracing */
+	self->trace = NULL;
+
+  /* Initialize xMean, to avoid non-sense calculations if user forget to do it */
+	ekArrayOpsD_fill(self->xMean, self->N, 0.0);
 }
 
 
@@ -58,34 +229,85 @@ void
 ekOptimizer_init(ekOptimizer* self, size_t N) {
 	size_t defaultLambda;
 
+	/* Default setting for mu & lambda */
+	defaultLambda = 4.0 + 3.0 * log((double)N);
+	ekOptimizer_initFromArena(self, N, defaultLambda, NULL);
+}
+
+
+
+int
+ekOptimizer_initFromArena(ekOptimizer* self, size_t N, size_t lambda, ekArena* arena) {
+	size_t i;
+
+	/* Checked at once, so that none of the allocations below fails */
+	if ((arena != NULL) && (ekArena_remaining(arena) < ekOptimizer_arenaSize(N, lambda)))
+		return 0;
+
 	self->N = N;
+	self->arena = arena;
 
 	/* Randomizer init & seeding (in case user forgot to seed) */
-	ekRandomizer_init(&(self->randomizer), ekRandomizerSize_1024);
+	ekRandomizer_initFromArena(&(self->randomizer), ekRandomizerSize_1024, arena);
 	ekRandomizer_seed(&(self->randomizer), 42);
 
 	/* Allocation independent from population size */
-	self->xMean        = newArray(double, N);
-	self->zMean        = newArray(double, N);
-	self->bestPoint.x  = newArray(double, N);
+	self->xMean        = ekArena_newArray(arena, double, N);
+	self->zMean        = ekArena_newArray(arena, double, N);
+	self->bestPoint.x  = ekArena_newArray(arena, double, N);
 	self->bestPoint.z  = NULL;
 
-	/* Default setting for mean weights */
-	self->meanWeightsGen = &ekLog_MeanWeightsGenerator;
-	self->meanWeightsSetupDone = 0;
-
 	/* No distribution set yet */
 	self->distrib.data = NULL;
 	self->distrib.delegate = ekNullDistribution_DistributionDelegate;
 
-	/* Default setting for mu & lambda */
-	defaultLambda = 4.0 + 3.0 * log((double)N);
-	ekOptimizer_setMuLambda(self, defaultLambda / 2, defaultLambda);
+	/* No sampling blocks nor observers */
+	self->blockRandomizers = NULL;
+	self->nbBlocks = 0;
+	self->pointRandomizers = NULL;
+	self->nbPointRandomizers = 0;
+	self->observers = NULL;
+	self->nbObservers = 0;
+	self->observersCapacity = 0;
+
+	/* No coordinate-major points */
+	self->coordsMemory = NULL;
+
+	/* No population yet */
+	self->pointArray = NULL;
+	self->points = NULL;
+	self->nbPointsMax = 0;
+
+	ekOptimizer_setDefaults(self);
+
+	ekOptimizer_setMuLambda(self, lambda / 2, lambda);
 
 	ekOptimizer_setup(self, self->lambda);
 
-  /* Initialize xMean, to avoid non-sense calculations if user forget to do it */
-	ekArrayOpsD_fill(self->xMean, N, 0.0);
+	/* Nothing is allocated later from an arena, the optional state is carved now */
+	if (arena != NULL) {
+		self->observers = ekArena_newArray(arena, ekObserver, ESKIT_ARENA_OBSERVERS);
+		self->observersCapacity = ESKIT_ARENA_OBSERVERS;
+		self->blockRandomizers = ekArena_newArray(arena, ekRandomizer, ESKIT_ARENA_BLOCKS);
+		for(i = 0; i < ESKIT_ARENA_BLOCKS; ++i)
+			ekRandomizer_initFromArena(self->blockRandomizers + i, ekRandomizerSize_1024, arena);
+		ekOptimizer_setupPointRandomizers(self);
+		ekOptimizer_setupCoords(self);
+	}
+
+	return 1;
+}
+
+
+
+void
+ekOptimizer_reset(ekOptimizer* self) {
+	/* The observers array is kept for the next ekOptimizer_addObserver */
+	ekOptimizer_releaseBlockRandomizers(self);
+	ekOptimizer_releasePointRandomizers(self);
+	self->nbObservers = 0;
+
+	ekOptimizer_setDefaults(self);
 }
 
 
@@ -94,21 +316,130 @@ void
 ekOptimizer_destroy(ekOptimizer* self) {
 	ekOptimizer_cleanup(self);
 
-	free(self->xMean);
-	free(self->zMean);
-	free(self->bestPoint.x);
+	if (self->arena == NULL) {
+		free(self->xMean);
+		free(self->zMean);
+		free(self->bestPoint.x);
+
+		ekRandomizer_destroy(&(self->randomizer));
+	}
+
+	ekOptimizer_releaseBlockRandomizers(self);
+	ekOptimizer_releasePointRandomizers(self);
+	ekOptimizer_releaseCoords(self);
 
-	ekRandomizer_destroy(&(self->randomizer));
+	if (self->arena == NULL)
+		free(self->observers);
 }
 
 
 
-void
+/* Heap memory allocated by ekOptimizer_setup */
+static size_t
+ekOptimizer_populationMemory(size_t N, size_t popSize) {
+	return
+		2 * popSize * sizeof(double) +
+		popSize * (sizeof(ekPoint) + sizeof(ekPoint*)) +
+		2 * ekMatrix_requiredMemory(popSize, N);
+}
+
+
+
+size_t
+ekOptimizer_requiredMemory(size_t N, size_t lambda) {
+	size_t defaultLambda;
+
+	/* ekOptimizer_init allocates for the default lambda, ekOptimizer_start may reallocate */
+	defaultLambda = 4.0 + 3.0 * log((double)N);
+	if (lambda < defaultLambda)
+		lambda = defaultLambda;
+
+	return
+		3 * N * sizeof(double) +
+		ekRandomizer_requiredMemory(ekRandomizerSize_1024) +
+		ekOptimizer_populationMemory(N, lambda);
+}
+
+
+
+/* Arena memory used by ekOptimizer_setup */
+static size_t
+ekOptimizer_populationArenaSize(size_t N, size_t popSize) {
+	return
+		2 * ekArena_alignedSize(popSize * sizeof(double)) +
+		ekArena_alignedSize(popSize * sizeof(ekPoint)) +
+		ekArena_alignedSize(popSize * sizeof(ekPoint*)) +
+		2 * ekMatrix_arenaSize(popSize, N);
+}
+
+
+
+size_t
+ekOptimizer_arenaSize(size_t N, size_t lambda) {
+	return
+		3 * ekArena_alignedSize(N * sizeof(double)) +
+		ekRandomizer_arenaSize(ekRandomizerSize_1024) +
+		ekOptimizer_populationArenaSize(N, lambda) +
+		ekArena_alignedSize(ESKIT_ARENA_OBSERVERS * sizeof(ekObserver)) +
+		ekArena_alignedSize(ESKIT_ARENA_BLOCKS * sizeof(ekRandomizer)) +
+		ESKIT_ARENA_BLOCKS * ekRandomizer_arenaSize(ekRandomizerSize_1024) +
+		ekArena_alignedSize(lambda * sizeof(ekRandomizer)) +
+		lambda * ekRandomizer_arenaSize(ekRandomizerSize_8) +
+		ekArena_alignedSize(ekOptimizer_coordsMemory(N, lambda));
+}
+
+
+
+size_t
+ekOptimizer_memoryUsage(const ekOptimizer* self) {
+	size_t i, ret;
+
+	ret =
+		3 * self->N * sizeof(double) +
+		ekRandomizer_memoryUsage(&(self->randomizer)) +
+		ekOptimizer_populationMemory(self->N, self->nbPointsMax) +
+		self->nbBlocks * sizeof(ekRandomizer) +
+		self->nbPointRandomizers * sizeof(ekRandomizer) +
+		self->nbObservers * sizeof(ekObserver);
+
+	for(i = 0; i < self->nbBlocks; ++i)
+		ret += ekRandomizer_memoryUsage(self->blockRandomizers + i);
+
+	for(i = 0; i < self->nbPointRandomizers; ++i)
+		ret += ekRandomizer_memoryUsage(self->pointRandomizers + i);
+
+	if (self->coordsMemory != NULL)
+		ret += ekOptimizer_coordsMemory(self->N, self->nbPointsMax);
+
+	return ret;
+}
+
+
+
+/* Number of generations without improvement before stalling */
+static size_t
+ekOptimizer_stallLimit(size_t N, size_t lambda) {
+	return 10 + floor((30.0 * N) / lambda);
+}
+
+
+
+int
 ekOptimizer_setMuLambda(ekOptimizer* self, size_t mu, size_t lambda) {
+	/* The population of an arena is never grown */
+	if ((self->arena != NULL) && (self->pointArray != NULL) && (lambda > self->nbPointsMax))
+		return 0;
+
 	self->mu = mu;
 	self->lambda = lambda;
-	self->nbUpdatesBestFitnessStalledLimit = 10 + floor((30.0 * self->N) / lambda);
+	self->configuredLambda = lambda;
+	self->nbUpdatesBestFitnessStalledLimit = ekOptimizer_stallLimit(self->N, lambda);
 	self->meanWeightsSetupDone = 0;
+
+	/* A population used with a larger lambda may be left sorted */
+	ekOptimizer_resetPoints(self);
+
+	return 1;
 }
 
 
@@ -128,6 +459,154 @@ ekOptimizer_setDistribution(ekOptimizer* self, const ekDistribution* distrib) {
 
 
 
+int
+ekOptimizer_setThreadPool(ekOptimizer* self, ekThreadPool* pool) {
+	size_t i;
+
+	if ((self->arena != NULL) && (pool != NULL) && (ekThreadPool_nbThreads(pool) > ESKIT_ARENA_BLOCKS))
+		return 0;
+
+	ekOptimizer_releaseBlockRandomizers(self);
+	self->threadPool = pool;
+
+	/* One block of columns, with its own random stream, per worker */
+	if (pool != NULL) {
+		self->nbBlocks = ekThreadPool_nbThreads(pool);
+		if (self->arena == NULL) {
+			self->blockRandomizers = newArray(ekRandomizer, self->nbBlocks);
+			for(i = 0; i < self->nbBlocks; ++i)
+				ekRandomizer_init(self->blockRandomizers + i, ekRandomizerSize_1024);
+		}
+
+		/* Past the start, the new streams would be left unseeded until the next one */
+		if (self->started && !self->deterministic)
+			for(i = 0; i < self->nbBlocks; ++i)
+				ekRandomizer_seed(self->blockRandomizers + i, ekRandomizer_next(&(self->randomizer)));
+	}
+
+	return 1;
+}
+
+
+
+void
+ekOptimizer_setFitnessCache(ekOptimizer* self, ekFitnessCache* cache) {
+	self->fitnessCache = cache;
+}
+
+
+
+void
+ekOptimizer_setEvaluationBudget(ekOptimizer* self, size_t maxEvaluations) {
+	self->maxEvaluations = maxEvaluations;
+}
+
+
+
+void
+ekOptimizer_setDeadline(ekOptimizer* self, double seconds) {
+	self->lastUpdateTime = ekClock_now();
+	self->deadline = self->lastUpdateTime + seconds;
+}
+
+
+
+void
+ekOptimizer_setLambdaShrinking(ekOptimizer* self, int enabled) {
+	self->lambdaShrinking = enabled;
+}
+
+
+
+void
+ekOptimizer_setDeterministic(ekOptimizer* self, int enabled) {
+	size_t i;
+
+	/* The block streams are not seeded by a deterministic start */
+	if (self->started && self->deterministic && !enabled)
+		for(i = 0; i < self->nbBlocks; ++i)
+			ekRandomizer_seed(self->blockRandomizers + i, ekRandomizer_next(&(self->randomizer)));
+
+	self->deterministic = enabled;
+
+	if (!enabled)
+		ekOptimizer_releasePointRandomizers(self);
+	else if (self->nbPointRandomizers < self->nbPointsMax)
+		ekOptimizer_setupPointRandomizers(self);
+}
+
+
+
+void
+ekOptimizer_setTrace(ekOptimizer* self, ekTrace* trace) {
+	self->trace = trace;
+}
+
+
+
+int
+ekOptimizer_addObserver(ekOptimizer* self, ekObserverFunc func, void* data) {
+	size_t capacity;
+	ekObserver* observers;
+
+	if (self->nbObservers == self->observersCapacity) {
+		if (self->arena != NULL)
+			return 0;
+
+		/* The observers already added are kept if the array can't grow */
+		capacity = (self->observersCapacity == 0) ? 4 : 2 * self->observersCapacity;
+		observers = (ekObserver*)realloc(self->observers, capacity * sizeof(ekObserver));
+		if (observers == NULL)
+			return 0;
+
+		self->observers = observers;
+		self->observersCapacity = capacity;
+	}
+
+	self->observers[self->nbObservers].func = func;
+	self->observers[self->nbObservers].data = data;
+	self->nbObservers += 1;
+
+	return 1;
+}
+
+
+
+void
+ekOptimizer_removeObserver(ekOptimizer* self, ekObserverFunc func, void* data) {
+	size_t i;
+
+	for(i = 0; i < self->nbObservers; ++i)
+		if ((self->observers[i].func == func) && (self->observers[i].data == data)) {
+			self->nbObservers -= 1;
+			for( ; i < self->nbObservers; ++i)
+				self->observers[i] = self->observers[i + 1];
+			break;
+		}
+}
+
+
+
+static void
+ekOptimizer_beginPhase(ekOptimizer* self, enum ekProfilePhase phase) {
+	ekProfile_begin(&(self->profile), phase);
+
+	if (self->trace != NULL)
+		ekTrace_begin(self->trace, phase, -1);
+}
+
+
+
+static void
+ekOptimizer_endPhase(ekOptimizer* self, enum ekProfilePhase phase) {
+	if (self->trace != NULL)
+		ekTrace_end(self->trace, phase, -1);
+
+	ekProfile_end(&(self->profile), phase);
+}
+
+
+
 static void
 ekOptimizer_setupMeanWeights(ekOptimizer* self) {
 	double sum;
@@ -141,11 +620,22 @@ ekOptimizer_setupMeanWeights(ekOptimizer* self) {
 
 void
 ekOptimizer_start(ekOptimizer* self) {
-	/* Allocate enough space for the run */
+	size_t i;
+
+	/* Undo the shrinking of lambda by the previous run */
+	if (self->lambda != self->configuredLambda) {
+		self->lambda = self->configuredLambda;
+		self->nbUpdatesBestFitnessStalledLimit = ekOptimizer_stallLimit(self->N, self->lambda);
+	}
+
+	/* Allocate enough space for the run, ekOptimizer_setMuLambda keeps an arena large enough */
 	if (self->nbPointsMax < self->lambda) {
 		ekOptimizer_cleanup(self);
 		ekOptimizer_setup(self, self->lambda);
-	} 
+	}
+
+	/* The points may still be ranked by the last update of a previous run */
+	ekOptimizer_resetPoints(self);
 
 	/* Generate the weights to compute the distribution center */
 	if (self->meanWeightsSetupDone == 0) {
@@ -153,12 +643,20 @@ ekOptimizer_start(ekOptimizer* self) {
 		self->meanWeightsSetupDone = 1;
 	}
 
+	/* Seed the per-block random streams from the optimizer random stream */
+	if (!self->deterministic)
+		for(i = 0; i < self->nbBlocks; ++i)
+			ekRandomizer_seed(self->blockRandomizers + i, ekRandomizer_next(&(self->randomizer)));
+
 	/* Start the distribution */
 	ekDistribution_start(&(self->distrib), self);
 
 	/* Job done */
+	self->started = 1;
 	self->nbUpdates = 0;
 	self->nbUpdatesBestFitnessStalled = 0;
+	self->nbEvaluations = 0;
+	self->lastUpdateTime = ekClock_now();
 }
 
 
@@ -168,14 +666,104 @@ ekOptimizer_samplePoint(ekOptimizer* self, size_t index) {
 	ekPoint* point;
 
 	point = self->points[index];
+	point->aborted = 0;
 	ekDistribution_samplePoint(&(self->distrib), self, index, point->x, point->z);
 }
 
 
 
+typedef struct {
+	ekOptimizer* optim;
+	ekMatrix* x;
+	ekMatrix* z;
+	ekSampleBlockFunc func;
+	void* data;
+} ekSampleBlocksJob;
+
+
+
+/* Samples the points [begin, end[, each one from its own random stream */
+static void
+ekOptimizer_samplePoints(ekOptimizer* self, ekMatrix* x, ekMatrix* z, ekSampleBlockFunc func, void* data, size_t begin, size_t end) {
+	size_t i;
+
+	for(i = begin; i < end; ++i)
+		func(data, self, self->pointRandomizers + i, x, z, i, i + 1);
+}
+
+
+
+static void
+ekOptimizer_sampleBlockTask(void* data, size_t blockId, size_t ESKIT_UNUSED(workerId)) {
+	size_t nbCols, nbBlocks;
+	ekSampleBlocksJob* job;
+
+	job = (ekSampleBlocksJob*)data;
+	nbCols = job->optim->lambda;
+	nbBlocks = job->optim->nbBlocks;
+
+	if (job->optim->trace != NULL)
+		ekTrace_begin(job->optim->trace, ekProfilePhase_Sample, blockId);
+
+	/* The block boundaries and random streams only depends on the block id */
+	if (job->optim->deterministic)
+		ekOptimizer_samplePoints(job->optim, job->x, job->z, job->func, job->data, (blockId * nbCols) / nbBlocks, ((blockId + 1) * nbCols) / nbBlocks);
+	else
+		job->func(job->data, 
+		          job->optim, 
+		          job->optim->blockRandomizers + blockId, 
+		          job->x, 
+		          job->z, 
+		          (blockId * nbCols) / nbBlocks, 
+		          ((blockId + 1) * nbCols) / nbBlocks);
+
+	if (job->optim->trace != NULL)
+		ekTrace_end(job->optim->trace, ekProfilePhase_Sample, blockId);
+}
+
+
+
+void
+ekOptimizer_sampleBlocks(ekOptimizer* self, ekMatrix* x, ekMatrix* z, ekSampleBlockFunc func, void* data) {
+	size_t i;
+	ekSampleBlocksJob job;
+
+	/* The streams of the points only depend on the optimizer stream */
+	if (self->deterministic)
+		for(i = 0; i < self->lambda; ++i)
+			ekRandomizer_seed(self->pointRandomizers + i, ekRandomizer_next(&(self->randomizer)));
+
+	if (self->threadPool == NULL) {
+		if (self->deterministic)
+			ekOptimizer_samplePoints(self, x, z, func, data, 0, self->lambda);
+		else
+			func(data, self, &(self->randomizer), x, z, 0, self->lambda);
+		return;
+	}
+
+	job.optim = self;
+	job.x = x;
+	job.z = z;
+	job.func = func;
+	job.data = data;
+	ekThreadPool_run(self->threadPool, ekOptimizer_sampleBlockTask, &job, self->nbBlocks);
+}
+
+
+
 void
 ekOptimizer_sampleCloud(ekOptimizer* self) {
+	size_t i;
+
+	ekOptimizer_beginPhase(self, ekProfilePhase_Sample);
+
+	for(i = 0; i < self->lambda; ++i)
+		self->pointArray[i].aborted = 0;
+	self->nbCacheHits = 0;
+
 	ekDistribution_sampleCloud(&(self->distrib), self, &(self->X), &(self->Z));
+
+	ekOptimizer_endPhase(self, ekProfilePhase_Sample);
 }
 
 
@@ -187,10 +775,55 @@ ekPoint_cmpFitness(const void* a, const void* b) {
 	u = *((const ekPoint**)a);
 	v = *((const ekPoint**)b);
 
+	/* Aborted evaluations are worse than all the complete ones */
+	if (u->aborted != v->aborted)
+		return u->aborted ? 1 : -1;
+
 	if (u->fitness < v->fitness)
 		return -1;
 
-	return u->fitness > v->fitness;
+	if (u->fitness > v->fitness)
+		return 1;
+
+	/* Ties are broken by the position of the points, for a total order */
+	return (u > v) - (u < v);
+}
+
+
+
+/* Moving average of the time per point of the generations */
+static void
+ekOptimizer_updateCostModel(ekOptimizer* self) {
+	double now, cost;
+
+	now = ekClock_now();
+	cost = (now - self->lastUpdateTime) / self->lambda;
+	self->lastUpdateTime = now;
+
+	if (self->pointCost == 0.0)
+		self->pointCost = cost;
+	else
+		self->pointCost = 0.7 * self->pointCost + 0.3 * cost;
+}
+
+
+
+static void
+ekOptimizer_notifyObservers(ekOptimizer* self) {
+	size_t i;
+	ekGenerationView view;
+
+	view.nbUpdates = self->nbUpdates;
+	view.nbEvaluations = self->nbEvaluations;
+	view.lambda = self->lambda;
+	view.bestX = self->bestPoint.x;
+	view.bestFitness = self->bestPoint.fitness;
+	view.generationBestFitness = self->points[0]->fitness;
+	view.xMean = self->xMean;
+	ekDistribution_view(&(self->distrib), self, &view);
+
+	for(i = 0; i < self->nbObservers; ++i)
+		self->observers[i].func(self->observers[i].data, self, &view);
 }
 
 
@@ -201,7 +834,9 @@ ekOptimizer_update(ekOptimizer* self) {
 	ekPoint* point;
 
 	/* Sort points according to their fitnesses (TODO : partial sort of the mu first) */
+	ekOptimizer_beginPhase(self, ekProfilePhase_Sort);
 	qsort(self->points, self->lambda, sizeof(ekPoint*), ekPoint_cmpFitness);
+	ekOptimizer_endPhase(self, ekProfilePhase_Sort);
 
 	/* Update best point ever */
 	point = self->points[0];
@@ -224,10 +859,63 @@ ekOptimizer_update(ekOptimizer* self) {
 		ekArrayOpsD_incMul(self->zMean, self->points[i]->z, self->N, self->meanWeights[i]);
 	
 	/* Update the distribution */
+	ekOptimizer_beginPhase(self, ekProfilePhase_DistributionUpdate);
 	ekDistribution_update(&(self->distrib), self);
+	ekOptimizer_endPhase(self, ekProfilePhase_DistributionUpdate);
 
 	/* Job done */
 	self->nbUpdates += 1;
+
+	/* Only the points actually evaluated count against the budget */
+	self->nbEvaluations += self->lambda - self->nbCacheHits;
+	self->nbCacheHits = 0;
+
+	if (self->deadline < HUGE_VAL)
+		ekOptimizer_updateCostModel(self);
+
+	if (self->nbObservers > 0)
+		ekOptimizer_notifyObservers(self);
+}
+
+
+
+/*
+   In deterministic mode, the whole population is looked up in the cache
+   before any evaluation, and the new fitnesses are inserted once all are
+   known, both in the order of the population. The hits and the evictions
+   then do not depend on the scheduling of the evaluations, but a point
+   never hits a point of its own generation.
+ */
+static int
+ekOptimizer_deferCache(const ekOptimizer* self) {
+	return self->deterministic && (self->fitnessCache != NULL);
+}
+
+
+
+static void
+ekOptimizer_lookupFitnesses(ekOptimizer* self) {
+	size_t i;
+	ekPoint* point;
+
+	point = self->pointArray;
+	for(i = 0; i < self->lambda; ++i, ++point) {
+		point->cached = ekFitnessCache_lookup(self->fitnessCache, point->x, &(point->fitness));
+		self->nbCacheHits += point->cached;
+	}
+}
+
+
+
+static void
+ekOptimizer_insertFitnesses(ekOptimizer* self) {
+	size_t i;
+	ekPoint* point;
+
+	point = self->pointArray;
+	for(i = 0; i < self->lambda; ++i, ++point)
+		if (!point->cached)
+			ekFitnessCache_insert(self->fitnessCache, point->x, point->fitness);
 }
 
 
@@ -235,20 +923,571 @@ ekOptimizer_update(ekOptimizer* self) {
 void
 ekOptimizer_evaluateFunction(ekOptimizer* self, double(*function)(const double*, size_t)) {
 	size_t i;
+	int deferCache;
 	ekPoint* point;
 
+	ekOptimizer_beginPhase(self, ekProfilePhase_Evaluate);
+
 	point = self->pointArray;
-	for(i = self->lambda; i != 0; --i, ++point)
-		point->fitness = function(point->x, self->N);
+	if ((self->fitnessCache == NULL) && (self->trace == NULL)) {
+		for(i = self->lambda; i != 0; --i, ++point)
+			point->fitness = function(point->x, self->N);
+	}
+	else {
+		deferCache = ekOptimizer_deferCache(self);
+		if (deferCache)
+			ekOptimizer_lookupFitnesses(self);
+
+		for(i = 0; i < self->lambda; ++i, ++point) {
+			if (self->trace != NULL)
+				ekTrace_begin(self->trace, ekProfilePhase_Evaluate, i);
+
+			if (deferCache) {
+				if (!point->cached)
+					point->fitness = function(point->x, self->N);
+			}
+			else if ((self->fitnessCache == NULL) || (!ekFitnessCache_lookup(self->fitnessCache, point->x, &(point->fitness)))) {
+				point->fitness = function(point->x, self->N);
+
+				if (self->fitnessCache != NULL)
+					ekFitnessCache_insert(self->fitnessCache, point->x, point->fitness);
+			}
+			else
+				self->nbCacheHits += 1;
+
+			if (self->trace != NULL)
+				ekTrace_end(self->trace, ekProfilePhase_Evaluate, i);
+		}
+
+		if (deferCache)
+			ekOptimizer_insertFitnesses(self);
+	}
+
+	ekOptimizer_endPhase(self, ekProfilePhase_Evaluate);
 }
 
 
 
-enum ekStopCriterionId
-ekOptimizer_stop(ekOptimizer* self) {
+const ekMatrix*
+ekOptimizer_coordinateMajorPoints(ekOptimizer* self) {
+	size_t i, j;
+	double* coord;
+
+	ekOptimizer_setupCoords(self);
+
+	for(i = 0; i < self->N; ++i) {
+		coord = ekMatrix_col(&(self->coords), i);
+
+		for(j = 0; j < self->lambda; ++j)
+			coord[j] = ekMatrix_at(&(self->X), j, i);
+
+		/* The padding repeats the last point, a valid point for any function */
+		for(; j < ekMatrix_nbRows(&(self->coords)); ++j)
+			coord[j] = coord[self->lambda - 1];
+	}
+
+	return &(self->coords);
+}
+
+
+
+void
+ekOptimizer_setFitnesses(ekOptimizer* self, const double* fitnesses) {
+	size_t i;
+	ekPoint* point;
+
+	point = self->pointArray;
+	for(i = 0; i < self->lambda; ++i, ++point) {
+		point->fitness = fitnesses[i];
+
+		if (self->fitnessCache != NULL)
+			ekFitnessCache_insert(self->fitnessCache, point->x, point->fitness);
+	}
+}
+
+
+
+int
+ekOptimizer_injectPoint(ekOptimizer* self, const double* x, double fitness) {
+	size_t i;
+	double norm;
+	ekPoint *point, *worst;
+
+	/* Same order as the ranking, aborted evaluations being the worst */
+	worst = self->pointArray;
+	for(i = 1, point = self->pointArray + 1; i < self->lambda; ++i, ++point)
+		if ((point->aborted > worst->aborted) || ((point->aborted == worst->aborted) && (point->fitness > worst->fitness)))
+			worst = point;
+
+	/* The fitness of an aborted point is only a lower bound */
+	if ((!worst->aborted) && (!(fitness < worst->fitness)))
+		return 0;
+
+	ekArrayOpsD_copy(worst->x, x, self->N);
+	worst->fitness = fitness;
+	worst->aborted = 0;
+	ekDistribution_project(&(self->distrib), self, x, worst->z);
+
+	/* A point far from the distribution would blow up the step length */
+	norm = sqrt(ekArrayOpsD_squareSum(worst->z, self->N));
+	if (norm > ekOptimizer_injectionMaxNorm(self->N))
+		ekArrayOpsD_scalarMul(worst->z, self->N, ekOptimizer_injectionMaxNorm(self->N) / norm);
+
+	return 1;
+}
+
+
+
+void
+ekOptimizer_evaluateBatchFunction(ekOptimizer* self, void(*function)(const ekMatrix*, size_t, double*)) {
+	const ekMatrix* coords;
+
+	ekOptimizer_beginPhase(self, ekProfilePhase_Evaluate);
+
+	coords = ekOptimizer_coordinateMajorPoints(self);
+	function(coords, self->lambda, self->coordsFitnesses);
+	ekOptimizer_setFitnesses(self, self->coordsFitnesses);
+
+	ekOptimizer_endPhase(self, ekProfilePhase_Evaluate);
+}
+
+
+
+typedef struct {
+	ekOptimizer* optim;
+	double(*function)(const double*, size_t);
+	int deferCache;
+	pthread_mutex_t cacheMutex;
+} ekEvaluateJob;
+
+
+
+static void
+ekOptimizer_evaluateRangeTask(void* data, size_t begin, size_t end, size_t ESKIT_UNUSED(workerId)) {
+	int found;
+	size_t i;
+	ekEvaluateJob* job;
+	ekOptimizer* self;
+	ekPoint* point;
+
+	job = (ekEvaluateJob*)data;
+	self = job->optim;
+
+	for(i = begin; i < end; ++i) {
+		point = self->pointArray + i;
+
+		if (self->trace != NULL)
+			ekTrace_begin(self->trace, ekProfilePhase_Evaluate, i);
+
+		/* The cache is shared by the workers, unless it is deferred */
+		found = 0;
+		if (job->deferCache)
+			found = point->cached;
+		else if (self->fitnessCache != NULL) {
+			pthread_mutex_lock(&(job->cacheMutex));
+			found = ekFitnessCache_lookup(self->fitnessCache, point->x, &(point->fitness));
+			self->nbCacheHits += found;
+			pthread_mutex_unlock(&(job->cacheMutex));
+		}
+
+		if (!found) {
+			point->fitness = job->function(point->x, self->N);
+
+			if ((self->fitnessCache != NULL) && (!job->deferCache)) {
+				pthread_mutex_lock(&(job->cacheMutex));
+				ekFitnessCache_insert(self->fitnessCache, point->x, point->fitness);
+				pthread_mutex_unlock(&(job->cacheMutex));
+			}
+		}
+
+		if (self->trace != NULL)
+			ekTrace_end(self->trace, ekProfilePhase_Evaluate, i);
+	}
+}
+
+
+
+void
+ekOptimizer_evaluateFunctionParallel(ekOptimizer* self, double(*function)(const double*, size_t)) {
+	size_t chunkSize, maxChunkSize, nbThreads;
+	double startTime, cost;
+	ekEvaluateJob job;
+
+	if (self->threadPool == NULL) {
+		ekOptimizer_evaluateFunction(self, function);
+		return;
+	}
+
+	ekOptimizer_beginPhase(self, ekProfilePhase_Evaluate);
+
+	/* Chunks lasting about ESKIT_EVALUATION_CHUNK_DURATION, a few per worker at most */
+	nbThreads = ekThreadPool_nbThreads(self->threadPool);
+	maxChunkSize = self->lambda / (4 * nbThreads);
+	chunkSize = 1;
+	if (self->evaluationCost > 0.0)
+		chunkSize = fmin(ESKIT_EVALUATION_CHUNK_DURATION / self->evaluationCost, maxChunkSize);
+	if (chunkSize == 0)
+		chunkSize = 1;
+
+	job.optim = self;
+	job.function = function;
+	job.deferCache = ekOptimizer_deferCache(self);
+	pthread_mutex_init(&(job.cacheMutex), NULL);
+
+	if (job.deferCache)
+		ekOptimizer_lookupFitnesses(self);
+
+	startTime = ekClock_now();
+	ekThreadPool_runRange(self->threadPool, ekOptimizer_evaluateRangeTask, &job, self->lambda, chunkSize);
+
+	/* Time of an evaluation, assuming all the workers were busy */
+	cost = ((ekClock_now() - startTime) * nbThreads) / self->lambda;
+	if (self->evaluationCost == 0.0)
+		self->evaluationCost = cost;
+	else
+		self->evaluationCost = 0.7 * self->evaluationCost + 0.3 * cost;
+
+	if (job.deferCache)
+		ekOptimizer_insertFitnesses(self);
+
+	pthread_mutex_destroy(&(job.cacheMutex));
+
+	ekOptimizer_endPhase(self, ekProfilePhase_Evaluate);
+}
+
+
+
+/* Inserts a fitness in a sorted array of at most size values, returns the new count */
+static size_t
+ekOptimizer_insertRacingFitness(double* fitnesses, size_t count, size_t size, double fitness) {
+	size_t i;
+
+	if (count == size) {
+		if (fitness >= fitnesses[count - 1])
+			return count;
+		count -= 1;
+	}
+
+	for(i = count; (i > 0) && (fitnesses[i - 1] > fitness); --i)
+		fitnesses[i] = fitnesses[i - 1];
+	fitnesses[i] = fitness;
+
+	return count + 1;
+}
+
+
+
+void
+ekOptimizer_evaluateFunctionRacing(ekOptimizer* self, double(*function)(const double*, size_t, double, int*)) {
+	size_t i, nbExact;
+	double threshold;
+	ekPoint* point;
+
+	ekOptimizer_beginPhase(self, ekProfilePhase_Evaluate);
+
+	nbExact = 0;
+	self->nbAborted = 0;
+
+	point = self->pointArray;
+	for(i = 0; i < self->lambda; ++i, ++point) {
+		/* No threshold until mu points are known */
+		threshold = (nbExact < self->mu) ? HUGE_VAL : self->racingFitnesses[self->mu - 1];
+
+		point->aborted = 0;
+		if ((self->fitnessCache == NULL) || (!ekFitnessCache_lookup(self->fitnessCache, point->x, &(point->fitness)))) {
+			if (self->trace != NULL)
+				ekTrace_begin(self->trace, ekProfilePhase_Evaluate, i);
+
+			point->fitness = function(point->x, self->N, threshold, &(point->aborted));
+
+			if (self->trace != NULL)
+				ekTrace_end(self->trace, ekProfilePhase_Evaluate, i);
+
+			if (point->aborted) {
+				self->nbAborted += 1;
+				continue;
+			}
+
+			if (self->fitnessCache != NULL)
+				ekFitnessCache_insert(self->fitnessCache, point->x, point->fitness);
+		}
+		else
+			self->nbCacheHits += 1;
+
+		nbExact = ekOptimizer_insertRacingFitness(self->racingFitnesses, nbExact, self->mu, point->fitness);
+	}
+
+	ekOptimizer_endPhase(self, ekProfilePhase_Evaluate);
+}
+
+
+
+/* Reduces lambda for the next generations, returns 0 if not allowed */
+static int
+ekOptimizer_shrinkLambda(ekOptimizer* self, size_t lambda) {
+	if ((!self->lambdaShrinking) || (lambda <= self->mu))
+		return 0;
+
+	self->lambda = lambda;
+	self->nbUpdatesBestFitnessStalledLimit = ekOptimizer_stallLimit(self->N, lambda);
+	ekOptimizer_resetPoints(self);
+
+	return 1;
+}
+
+
+
+static int
+ekOptimizer_fitEvaluationBudget(ekOptimizer* self) {
+	if ((self->maxEvaluations == 0) || (self->nbEvaluations + self->lambda <= self->maxEvaluations))
+		return 1;
+
+	if (self->nbEvaluations >= self->maxEvaluations)
+		return 0;
+
+	return ekOptimizer_shrinkLambda(self, self->maxEvaluations - self->nbEvaluations);
+}
+
+
+
+static int
+ekOptimizer_fitDeadline(ekOptimizer* self) {
+	double timeLeft;
+
+	if (self->deadline == HUGE_VAL)
+		return 1;
+
+	timeLeft = self->deadline - ekClock_now();
+	if (self->pointCost * self->lambda <= timeLeft)
+		return 1;
+
+	if (timeLeft <= 0.0)
+		return 0;
+
+	return ekOptimizer_shrinkLambda(self, (size_t)floor(timeLeft / self->pointCost));
+}
+
+
+
+static enum ekStopCriterionId
+ekOptimizer_checkStop(ekOptimizer* self) {
+	enum ekStopCriterionId ret;
+
 	if (self->nbUpdatesBestFitnessStalled > self->nbUpdatesBestFitnessStalledLimit)
 		return ekStopCriterionId_BestFitnessStall;
 
-	return ekDistribution_stop(&(self->distrib), self);
+	ret = ekDistribution_stop(&(self->distrib), self);
+	if (ret != ekStopCriterionId_None)
+		return ret;
+
+	/* Would the next generation overrun the budget or the deadline ? */
+	if (!ekOptimizer_fitEvaluationBudget(self))
+		return ekStopCriterionId_EvaluationBudget;
+
+	if (!ekOptimizer_fitDeadline(self))
+		return ekStopCriterionId_Deadline;
+
+	return ekStopCriterionId_None;
+}
+
+
+
+enum ekStopCriterionId
+ekOptimizer_stop(ekOptimizer* self) {
+	enum ekStopCriterionId ret;
+
+	ekOptimizer_beginPhase(self, ekProfilePhase_Stop);
+	ret = ekOptimizer_checkStop(self);
+	ekOptimizer_endPhase(self, ekProfilePhase_Stop);
+
+	return ret;
 }
 
+
+
+
+/* --- Checkpoint ---------------------------------------------------------- */
+
+static int
+ekOptimizer_savePoints(ekOptimizer* self, FILE* file) {
+	size_t i, index;
+
+	/* Coordinates, stored as the lambda first columns of X and Z */
+	if (!(ekCheckpoint_writeArray(file, self->X.tuple, self->lambda * self->N) &&
+	      ekCheckpoint_writeArray(file, self->Z.tuple, self->lambda * self->N)))
+		return 0;
+
+	/* Fitnesses and ranking of the points */
+	for(i = 0; i < self->lambda; ++i) {
+		index = self->points[i] - self->pointArray;
+		if (!(ekCheckpoint_writeDouble(file, self->pointArray[i].fitness) && 
+		      ekCheckpoint_writeSize(file, self->pointArray[i].aborted) &&
+		      ekCheckpoint_writeSize(file, index)))
+			return 0;
+	}
+
+	return 1;
+}
+
+
+
+static int
+ekOptimizer_loadPoints(ekOptimizer* self, FILE* file) {
+	size_t i, index, aborted;
+
+	if (!(ekCheckpoint_readArray(file, self->X.tuple, self->lambda * self->N) &&
+	      ekCheckpoint_readArray(file, self->Z.tuple, self->lambda * self->N)))
+		return 0;
+
+	for(i = 0; i < self->lambda; ++i) {
+		if (!(ekCheckpoint_readDouble(file, &(self->pointArray[i].fitness)) && 
+		      ekCheckpoint_readSize(file, &aborted) &&
+		      ekCheckpoint_readSize(file, &index)))
+			return 0;
+
+		self->pointArray[i].aborted = (aborted != 0);
+
+		if (index >= self->lambda)
+			return 0;
+
+		self->points[i] = self->pointArray + index;
+	}
+
+	return 1;
+}
+
+
+
+static int
+ekOptimizer_saveBlockRandomizers(ekOptimizer* self, FILE* file) {
+	size_t i;
+
+	if (!ekCheckpoint_writeSize(file, self->nbBlocks))
+		return 0;
+
+	for(i = 0; i < self->nbBlocks; ++i)
+		if (!ekCheckpoint_writeRandomizer(file, self->blockRandomizers + i))
+			return 0;
+
+	return 1;
+}
+
+
+
+static int
+ekOptimizer_loadBlockRandomizers(ekOptimizer* self, FILE* file) {
+	size_t i, nbBlocks;
+
+	if (!ekCheckpoint_readSize(file, &nbBlocks))
+		return 0;
+
+	if (nbBlocks == self->nbBlocks) {
+		for(i = 0; i < self->nbBlocks; ++i)
+			if (!ekCheckpoint_readRandomizer(file, self->blockRandomizers + i))
+				return 0;
+
+		return 1;
+	}
+
+	/* Different number of threads : the stored streams are useless */
+	for(i = 0; i < nbBlocks; ++i)
+		if (!ekCheckpoint_skipRandomizer(file))
+			return 0;
+
+	/* The streams of the points do not depend on the threads */
+	if (!self->deterministic)
+		for(i = 0; i < self->nbBlocks; ++i)
+			ekRandomizer_seed(self->blockRandomizers + i, ekRandomizer_next(&(self->randomizer)));
+
+	return 1;
+}
+
+
+
+int
+ekOptimizer_save(ekOptimizer* self, FILE* file) {
+	uint32_t header[2];
+
+	header[0] = ESKIT_CHECKPOINT_MAGIC;
+	header[1] = ESKIT_CHECKPOINT_VERSION;
+
+	return
+		ekCheckpoint_write(file, header, sizeof(header)) &&
+		ekCheckpoint_writeString(file, self->distrib.delegate.name) &&
+		ekCheckpoint_writeSize(file, self->N) &&
+		ekCheckpoint_writeSize(file, self->mu) &&
+		ekCheckpoint_writeSize(file, self->lambda) &&
+		ekCheckpoint_writeSize(file, self->configuredLambda) &&
+		ekCheckpoint_writeSize(file, self->nbUpdates) &&
+		ekCheckpoint_writeSize(file, self->nbUpdatesBestFitnessStalled) &&
+		ekCheckpoint_writeSize(file, self->nbUpdatesBestFitnessStalledLimit) &&
+		ekCheckpoint_writeSize(file, self->nbEvaluations) &&
+		ekCheckpoint_writeDouble(file, self->pointCost) &&
+		ekCheckpoint_writeArray(file, self->meanWeights, self->mu) &&
+		ekCheckpoint_writeArray(file, self->xMean, self->N) &&
+		ekCheckpoint_writeArray(file, self->zMean, self->N) &&
+		ekCheckpoint_writeArray(file, self->bestPoint.x, self->N) &&
+		ekCheckpoint_writeDouble(file, self->bestPoint.fitness) &&
+		ekOptimizer_savePoints(self, file) &&
+		ekCheckpoint_writeRandomizer(file, &(self->randomizer)) &&
+		ekOptimizer_saveBlockRandomizers(self, file) &&
+		ekDistribution_save(&(self->distrib), self, file) &&
+		(fflush(file) == 0);
+}
+
+
+
+int
+ekOptimizer_load(ekOptimizer* self, FILE* file) {
+	uint32_t header[2];
+	size_t N, mu, lambda, configuredLambda;
+
+	/* Check the checkpoint matches the optimizer */
+	if (!ekCheckpoint_read(file, header, sizeof(header)))
+		return 0;
+
+	if ((header[0] != ESKIT_CHECKPOINT_MAGIC) || (header[1] != ESKIT_CHECKPOINT_VERSION))
+		return 0;
+
+	if (!ekCheckpoint_checkString(file, self->distrib.delegate.name))
+		return 0;
+
+	if (!(ekCheckpoint_readSize(file, &N) &&
+	      ekCheckpoint_readSize(file, &mu) &&
+	      ekCheckpoint_readSize(file, &lambda) &&
+	      ekCheckpoint_readSize(file, &configuredLambda)))
+		return 0;
+
+	if ((N != self->N) || (mu > lambda) || (lambda > configuredLambda))
+		return 0;
+
+	/* Population size, the lambda of the run may have been shrunk */
+	if (!ekOptimizer_setMuLambda(self, mu, configuredLambda))
+		return 0;
+
+	if (self->nbPointsMax < self->configuredLambda) {
+		ekOptimizer_cleanup(self);
+		ekOptimizer_setup(self, self->configuredLambda);
+	}
+
+	self->lambda = lambda;
+
+	/* State of the optimizer, then of its distribution */
+	self->meanWeightsSetupDone = 1;
+	self->started = 1;
+	return
+		ekCheckpoint_readSize(file, &(self->nbUpdates)) &&
+		ekCheckpoint_readSize(file, &(self->nbUpdatesBestFitnessStalled)) &&
+		ekCheckpoint_readSize(file, &(self->nbUpdatesBestFitnessStalledLimit)) &&
+		ekCheckpoint_readSize(file, &(self->nbEvaluations)) &&
+		ekCheckpoint_readDouble(file, &(self->pointCost)) &&
+		ekCheckpoint_readArray(file, self->meanWeights, self->mu) &&
+		ekCheckpoint_readArray(file, self->xMean, self->N) &&
+		ekCheckpoint_readArray(file, self->zMean, self->N) &&
+		ekCheckpoint_readArray(file, self->bestPoint.x, self->N) &&
+		ekCheckpoint_readDouble(file, &(self->bestPoint.fitness)) &&
+		ekOptimizer_loadPoints(self, file) &&
+		ekCheckpoint_readRandomizer(file, &(self->randomizer)) &&
+		ekOptimizer_loadBlockRandomizers(self, file) &&
+		ekDistribution_load(&(self->distrib), self, file);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <stdlib.h>
+#include "eskit/Macros.h"
+#include "eskit/OptimizerPool.h"
+
+
+
+void
+ekOptimizerPool_init(ekOptimizerPool* self, const ekDistributionBuilder* builder, double sigmaInit, double sigmaStop) {
+	self->builder = builder;
+	self->sigmaInit = sigmaInit;
+	self->sigmaStop = sigmaStop;
+
+	/* Copying a seeded state is cheaper than seeding */
+	ekRandomizer_init(&(self->seededRandomizer), ekRandomizerSize_1024);
+	ekRandomizer_seed(&(self->seededRandomizer), 42);
+
+	pthread_mutex_init(&(self->mutex), NULL);
+	self->freeList = NULL;
+	self->nbFree = 0;
+	self->nbCreated = 0;
+}
+
+
+
+void
+ekOptimizerPool_destroy(ekOptimizerPool* self) {
+	ekPooledOptimizer* item;
+
+	while(self->freeList != NULL) {
+		item = self->freeList;
+		self->freeList = item->next;
+
+		ekOptimizer_destroy(&(item->optim));
+		ekDistribution_destroy(&(item->distrib), self->builder);
+		free(item);
+	}
+
+	ekRandomizer_destroy(&(self->seededRandomizer));
+	pthread_mutex_destroy(&(self->mutex));
+}
+
+
+
+static ekPooledOptimizer*
+ekOptimizerPool_create(ekOptimizerPool* self, size_t N, size_t lambda) {
+	ekPooledOptimizer* ret;
+
+	ret = new(ekPooledOptimizer);
+	ekOptimizer_initFromArena(&(ret->optim), N, lambda, NULL);
+	ekDistribution_initFromBuilder(&(ret->distrib), self->builder, N, self->sigmaInit, self->sigmaStop);
+	ekOptimizer_setDistribution(&(ret->optim), &(ret->distrib));
+
+	return ret;
+}
+
+
+
+void
+ekOptimizerPool_reserve(ekOptimizerPool* self, size_t N, size_t lambda, size_t count) {
+	size_t i;
+
+	for(i = 0; i < count; ++i)
+		ekOptimizerPool_release(self, &(ekOptimizerPool_create(self, N, lambda)->optim));
+
+	pthread_mutex_lock(&(self->mutex));
+	self->nbCreated += count;
+	pthread_mutex_unlock(&(self->mutex));
+}
+
+
+
+ekOptimizer*
+ekOptimizerPool_acquire(ekOptimizerPool* self, size_t N, size_t lambda) {
+	ekPooledOptimizer *item, **link;
+
+	/* First free optimizer of that dimension with a large enough population */
+	pthread_mutex_lock(&(self->mutex));
+	for(link = &(self->freeList); (*link) != NULL; link = &((*link)->next))
+		if (((*link)->optim.N == N) && ((*link)->optim.nbPointsMax >= lambda))
+			break;
+
+	item = *link;
+	if (item != NULL) {
+		*link = item->next;
+		self->nbFree -= 1;
+	}
+	else
+		self->nbCreated += 1;
+	pthread_mutex_unlock(&(self->mutex));
+
+	if (item == NULL)
+		return &(ekOptimizerPool_create(self, N, lambda)->optim);
+
+	ekOptimizer_reset(&(item->optim));
+	ekRandomizer_copy(ekOptimizer_getRandomizer(&(item->optim)), &(self->seededRandomizer));
+	ekOptimizer_setDistribution(&(item->optim), &(item->distrib));
+	ekOptimizer_setMuLambda(&(item->optim), lambda / 2, lambda);
+
+	return &(item->optim);
+}
+
+
+
+void
+ekOptimizerPool_release(ekOptimizerPool* self, ekOptimizer* optim) {
+	ekPooledOptimizer* item;
+
+	item = (ekPooledOptimizer*)optim;
+
+	pthread_mutex_lock(&(self->mutex));
+	item->next = self->freeList;
+	self->freeList = item;
+	self->nbFree += 1;
+	pthread_mutex_unlock(&(self->mutex));
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "eskit/Macros.h"
+#include "eskit/Arena.h"
+#include "eskit/Optimizer.h"
+#include "eskit/ProcessFarm.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+
+
+/* Delay between two checks of the workers health, in seconds */
+#define ekProcessFarm_pollPeriod 0.01
+
+
+
+enum ekProcessFarmState {
+	ekProcessFarmState_Idle = 0,
+	ekProcessFarmState_Busy,     /* A point is assigned to the worker      */
+	ekProcessFarmState_Done,     /* The fitness of the point is available  */
+	ekProcessFarmState_Exit      /* The worker should exit                 */
+};
+
+
+
+/* Lives in the shared memory segment, guarded by its doorbell */
+struct s_ekProcessFarmSlot {
+	ekDoorbell bell;             /* Rung by the farm when the state changes */
+	enum ekProcessFarmState state;
+	size_t pointIndex;
+	double fitness;
+	double* x;
+};
+
+
+
+static void
+ekProcessFarm_workerMain(ekProcessFarm* self, struct s_ekProcessFarmSlot* slot) {
+	uint32_t count;
+	enum ekProcessFarmState state;
+
+	count = ekDoorbell_count(&(slot->bell));
+	while(1) {
+		ekDoorbell_lock(&(slot->bell));
+		state = slot->state;
+		ekDoorbell_unlock(&(slot->bell));
+
+		if (state == ekProcessFarmState_Exit)
+			_exit(0);
+
+		if (state != ekProcessFarmState_Busy) {
+			count = ekDoorbell_wait(&(slot->bell), count, HUGE_VAL);
+			continue;
+		}
+
+		/* The point is not modified by the farm while the worker is busy */
+		slot->fitness = self->function(slot->x, self->N);
+
+		ekDoorbell_lock(&(slot->bell));
+		slot->state = ekProcessFarmState_Done;
+		ekDoorbell_unlock(&(slot->bell));
+
+		ekDoorbell_ring(self->doneBell);
+	}
+}
+
+
+
+/* Returns 0 if the fork failed, the slot being left without a worker */
+static int
+ekProcessFarm_spawn(ekProcessFarm* self, size_t id) {
+	pid_t pid;
+
+	/* A fresh doorbell, the previous worker may have died waiting on it */
+	ekDoorbell_init(&(self->slots[id].bell));
+	self->slots[id].state = ekProcessFarmState_Idle;
+
+	pid = fork();
+	if (pid == 0)
+		ekProcessFarm_workerMain(self, self->slots + id);
+
+	/* No point is assigned to a slot without a worker */
+	if (pid < 0) {
+		ekDoorbell_destroy(&(self->slots[id].bell));
+		self->slots[id].state = ekProcessFarmState_Exit;
+	}
+
+	self->pids[id] = pid;
+	return pid > 0;
+}
+
+
+
+int
+ekProcessFarm_init(ekProcessFarm* self, size_t N, size_t nbWorkers, double(*function)(const double*, size_t)) {
+	size_t i;
+	ekArena arena;
+
+	if (nbWorkers == 0)
+		nbWorkers = 1;
+
+	self->N = N;
+	self->nbWorkers = nbWorkers;
+	self->function = function;
+	self->nbRespawns = 0;
+
+	self->pending = NULL;
+	self->nbCrashes = NULL;
+	self->capacity = 0;
+
+	/* The segment is mapped at the same address in the forked workers */
+	self->sharedSize =
+		ekArena_alignedSize(sizeof(ekDoorbell)) +
+		ekArena_alignedSize(nbWorkers * sizeof(struct s_ekProcessFarmSlot)) +
+		nbWorkers * ekArena_alignedSize(N * sizeof(double));
+	self->shared = mmap(NULL, self->sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (self->shared == MAP_FAILED)
+		return 0;
+
+	ekArena_init(&arena, self->shared, self->sharedSize);
+	self->doneBell = (ekDoorbell*)ekArena_alloc(&arena, sizeof(ekDoorbell));
+	self->slots = ekArena_newArray(&arena, struct s_ekProcessFarmSlot, nbWorkers);
+	for(i = 0; i < nbWorkers; ++i)
+		self->slots[i].x = ekArena_newArray(&arena, double, N);
+
+	ekDoorbell_init(self->doneBell);
+
+	self->pids = newArray(pid_t, nbWorkers);
+	for(i = 0; i < nbWorkers; ++i) {
+		if (!ekProcessFarm_spawn(self, i)) {
+			self->nbWorkers = i;
+			ekProcessFarm_destroy(self);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+
+void
+ekProcessFarm_destroy(ekProcessFarm* self) {
+	size_t i;
+
+	for(i = 0; i < self->nbWorkers; ++i) {
+		if (self->pids[i] <= 0)
+			continue;
+		ekDoorbell_lock(&(self->slots[i].bell));
+		self->slots[i].state = ekProcessFarmState_Exit;
+		ekDoorbell_unlock(&(self->slots[i].bell));
+		ekDoorbell_ring(&(self->slots[i].bell));
+	}
+
+	for(i = 0; i < self->nbWorkers; ++i) {
+		if (self->pids[i] <= 0)
+			continue;
+		waitpid(self->pids[i], NULL, 0);
+		ekDoorbell_destroy(&(self->slots[i].bell));
+	}
+
+	ekDoorbell_destroy(self->doneBell);
+	munmap(self->shared, self->sharedSize);
+
+	free(self->pids);
+	free(self->pending);
+	free(self->nbCrashes);
+}
+
+
+
+/*
+   Respawns the dead workers, putting back their point in the pending ones.
+   A slot left without a worker by a failed fork is retried at each check.
+ */
+static size_t
+ekProcessFarm_checkWorkers(ekProcessFarm* self, ekOptimizer* optim, size_t* nbPending) {
+	size_t i, index, nbLost;
+	struct s_ekProcessFarmSlot* slot;
+
+	nbLost = 0;
+	for(i = 0; i < self->nbWorkers; ++i) {
+		/* waitpid(-1) would reap any child of the process */
+		if (self->pids[i] <= 0) {
+			if (ekProcessFarm_spawn(self, i))
+				self->nbRespawns += 1;
+			continue;
+		}
+
+		if (waitpid(self->pids[i], NULL, WNOHANG) != self->pids[i])
+			continue;
+
+		slot = self->slots + i;
+		if (slot->state == ekProcessFarmState_Busy) {
+			index = slot->pointIndex;
+			nbLost += 1;
+
+			/* A point killing its workers again and again is given up */
+			self->nbCrashes[index] += 1;
+			if (self->nbCrashes[index] < ESKIT_PROCESS_FARM_MAX_CRASHES) {
+				self->pending[*nbPending] = index;
+				*nbPending += 1;
+			}
+			else
+				ekOptimizer_point(optim, index).fitness = HUGE_VAL;
+		}
+		else if (slot->state == ekProcessFarmState_Done) {
+			ekOptimizer_point(optim, slot->pointIndex).fitness = slot->fitness;
+			nbLost += 1;
+		}
+
+		if (ekProcessFarm_spawn(self, i))
+			self->nbRespawns += 1;
+	}
+
+	return nbLost;
+}
+
+
+
+void
+ekProcessFarm_evaluate(ekProcessFarm* self, ekOptimizer* optim) {
+	int progress, assigned;
+	size_t i, lambda, nbPending, nbBusy;
+	uint32_t count;
+	enum ekProcessFarmState state;
+	struct s_ekProcessFarmSlot* slot;
+	ekPoint* point;
+
+	lambda = ekOptimizer_lambda(optim);
+	if (self->capacity < lambda) {
+		free(self->pending);
+		free(self->nbCrashes);
+		self->pending = newArray(size_t, lambda);
+		self->nbCrashes = newArray(unsigned char, lambda);
+		self->capacity = lambda;
+	}
+
+	ekProfile_begin(ekOptimizer_profile(optim), ekProfilePhase_Evaluate);
+
+	/* Pending points as a stack, the first points being assigned first */
+	for(i = 0; i < lambda; ++i) {
+		self->pending[i] = lambda - i - 1;
+		self->nbCrashes[i] = 0;
+	}
+	nbPending = lambda;
+	nbBusy = 0;
+
+	while((nbPending > 0) || (nbBusy > 0)) {
+		count = ekDoorbell_count(self->doneBell);
+		progress = 0;
+
+		for(i = 0; i < self->nbWorkers; ++i) {
+			slot = self->slots + i;
+
+			ekDoorbell_lock(&(slot->bell));
+			state = slot->state;
+			assigned = 0;
+
+			/* Collect a fitness */
+			if (state == ekProcessFarmState_Done) {
+				ekOptimizer_point(optim, slot->pointIndex).fitness = slot->fitness;
+				state = slot->state = ekProcessFarmState_Idle;
+				nbBusy -= 1;
+				progress = 1;
+			}
+
+			/* Assign a point */
+			if ((state == ekProcessFarmState_Idle) && (nbPending > 0)) {
+				nbPending -= 1;
+				point = &ekOptimizer_point(optim, self->pending[nbPending]);
+				memcpy(slot->x, point->x, self->N * sizeof(double));
+				slot->pointIndex = self->pending[nbPending];
+				slot->state = ekProcessFarmState_Busy;
+				nbBusy += 1;
+				assigned = progress = 1;
+			}
+
+			ekDoorbell_unlock(&(slot->bell));
+
+			if (assigned)
+				ekDoorbell_ring(&(slot->bell));
+		}
+
+		/* Nothing to do until a worker is done, or found dead after a while */
+		if ((!progress) && (ekDoorbell_wait(self->doneBell, count, ekProcessFarm_pollPeriod) == count))
+			nbBusy -= ekProcessFarm_checkWorkers(self, optim, &nbPending);
+	}
+
+	ekProfile_end(ekOptimizer_profile(optim), ekProfilePhase_Evaluate);
+}
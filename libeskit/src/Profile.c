@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include "eskit/Profile.h"
+
+
+
+static const char*
+ekProfilePhaseStringArray[] =
+{
+	"Sample",
+	"Evaluate",
+	"Sort",
+	"DistributionUpdate",
+	"EigenSolve",
+	"Stop"
+};
+
+
+
+static const char*
+ekProfilePhaseStringUndefined = "Undefined";
+
+
+
+void
+ekProfile_reset(ekProfile* self) {
+	size_t i;
+
+	for(i = 0; i < ekProfilePhase_Count; ++i) {
+		self->time[i] = 0.0;
+		self->nbCalls[i] = 0;
+		self->start[i] = 0.0;
+	}
+}
+
+
+
+const char*
+ekProfilePhaseString(enum ekProfilePhase phase) {
+	if (phase >= ekProfilePhase_Count)
+		return ekProfilePhaseStringUndefined;
+
+	return ekProfilePhaseStringArray[phase];
+}
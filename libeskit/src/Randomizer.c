@@ -57,13 +57,20 @@ ekRandomizer_reset(ekRandomizer* self) {
 
 void
 ekRandomizer_init(ekRandomizer* self, enum ekRandomizerSize size) {
+	ekRandomizer_initFromArena(self, size, NULL);
+}
+
+
+
+void
+ekRandomizer_initFromArena(ekRandomizer* self, enum ekRandomizerSize size, ekArena* arena) {
 	const ekRandomizerSetting* setting;
 
 	setting =  ekRandomizerSettingsList + size;
 	self->multiplier = setting->multiplier;
 	self->size = setting->size;
 
-	self->array = newArray(uint32_t, self->size);
+	self->array = ekArena_newArray(arena, uint32_t, self->size);
 }
 
 
@@ -75,6 +82,27 @@ ekRandomizer_destroy(ekRandomizer* self) {
 
 
 
+size_t
+ekRandomizer_requiredMemory(enum ekRandomizerSize size) {
+	return ekRandomizerSettingsList[size].size * sizeof(uint32_t);
+}
+
+
+
+size_t
+ekRandomizer_memoryUsage(const ekRandomizer* self) {
+	return self->size * sizeof(uint32_t);
+}
+
+
+
+size_t
+ekRandomizer_arenaSize(enum ekRandomizerSize size) {
+	return ekArena_alignedSize(ekRandomizer_requiredMemory(size));
+}
+
+
+
 void
 ekRandomizer_copy(ekRandomizer* self, const ekRandomizer* rnd) {
 	if (self->size != rnd->size) {
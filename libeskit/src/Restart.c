@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "eskit/Macros.h"
+#include "eskit/Matrix.h"
+#include "eskit/ArrayOps.h"
+#include "eskit/Optimizer.h"
+#include "eskit/Restart.h"
+
+
+
+/* Settings of one restart, decided when a worker asks for a new restart */
+typedef struct {
+	size_t lambda;
+	double sigma;
+	uint32_t seed;
+	int isLarge;
+} ekRestartPlan;
+
+
+
+void
+ekRestart_init(ekRestart* self, size_t N, const ekDistributionBuilder* builder) {
+	self->N = N;
+	self->builder = builder;
+	self->strategy = ekRestartStrategy_IPOP;
+
+	self->sigmaInit = 1.0;
+	self->sigmaStop = 10e-12;
+	self->lambdaInit = 4.0 + 3.0 * log((double)N);
+
+	self->xMeanInit = newArray(double, N);
+	ekArrayOpsD_fill(self->xMeanInit, N, 0.0);
+	self->lowerBound = NULL;
+	self->upperBound = NULL;
+
+	self->maxEvaluations = 1000 * N * N;
+	self->targetFitness = -HUGE_VAL;
+
+	self->threadPool = NULL;
+	ekRandomizer_init(&(self->randomizer), ekRandomizerSize_1024);
+	ekRandomizer_seed(&(self->randomizer), 42);
+
+	pthread_mutex_init(&(self->mutex), NULL);
+	self->bestX = newArray(double, N);
+	self->bestFitness = HUGE_VAL;
+	self->nbEvaluations = 0;
+	self->nbRestarts = 0;
+}
+
+
+
+void
+ekRestart_destroy(ekRestart* self) {
+	free(self->xMeanInit);
+	free(self->lowerBound);
+	free(self->upperBound);
+	free(self->bestX);
+
+	pthread_mutex_destroy(&(self->mutex));
+	ekRandomizer_destroy(&(self->randomizer));
+}
+
+
+
+void
+ekRestart_setStrategy(ekRestart* self, enum ekRestartStrategy strategy) {
+	self->strategy = strategy;
+}
+
+
+
+void
+ekRestart_setSigma(ekRestart* self, double sigmaInit, double sigmaStop) {
+	self->sigmaInit = sigmaInit;
+	self->sigmaStop = sigmaStop;
+}
+
+
+
+void
+ekRestart_setLambda(ekRestart* self, size_t lambda) {
+	self->lambdaInit = lambda;
+}
+
+
+
+void
+ekRestart_setBounds(ekRestart* self, const double* lower, const double* upper) {
+	if (self->lowerBound == NULL) {
+		self->lowerBound = newArray(double, self->N);
+		self->upperBound = newArray(double, self->N);
+	}
+
+	ekArrayOpsD_copy(self->lowerBound, lower, self->N);
+	ekArrayOpsD_copy(self->upperBound, upper, self->N);
+}
+
+
+
+void
+ekRestart_setBudget(ekRestart* self, size_t maxEvaluations) {
+	self->maxEvaluations = maxEvaluations;
+}
+
+
+
+void
+ekRestart_setTargetFitness(ekRestart* self, double targetFitness) {
+	self->targetFitness = targetFitness;
+}
+
+
+
+void
+ekRestart_setThreadPool(ekRestart* self, ekThreadPool* pool) {
+	self->threadPool = pool;
+}
+
+
+
+/* --- Restart schedule, all called with the mutex held -------------------- */
+
+/* Doubles lambdaInit for each large restart of the worker, within the budget */
+static size_t
+ekRestart_largeLambda(const ekRestart* self, size_t nbLargeRestarts) {
+	size_t i, lambda;
+
+	lambda = self->lambdaInit;
+	for(i = 0; (i < nbLargeRestarts) && (lambda <= self->maxEvaluations / 2); ++i)
+		lambda *= 2;
+
+	return lambda;
+}
+
+
+
+static void
+ekRestart_planLarge(ekRestart* self, ekRestartPlan* plan, size_t* nbLargeRestarts) {
+	plan->lambda = ekRestart_largeLambda(self, *nbLargeRestarts);
+	plan->sigma = self->sigmaInit;
+	plan->isLarge = 1;
+
+	*nbLargeRestarts += 1;
+	self->nbLargeRestarts += 1;
+}
+
+
+
+static void
+ekRestart_planSmall(ekRestart* self, ekRestartPlan* plan, size_t nbLargeRestarts) {
+	double u, lambdaRatio;
+
+	/* Ratio between the last large population size of the worker and the initial one */
+	lambdaRatio = (double)ekRestart_largeLambda(self, nbLargeRestarts - 1) / self->lambdaInit;
+
+	/* Small regime of BIPOP, lambdaInit (lambdaLarge / (2 lambdaInit))^(u^2) */
+	u = ekRandomizer_nextUniform(&(self->randomizer));
+	plan->lambda = floor(self->lambdaInit * pow(0.5 * lambdaRatio, u * u));
+	plan->sigma = self->sigmaInit * pow(10.0, -2.0 * u);
+	plan->isLarge = 0;
+}
+
+
+
+/*
+   Plans the next restart of a worker, which keeps its own count of large
+   restarts, so that concurrent workers do not double lambda for each other.
+   Returns 0 once the target is reached, or if the budget left does not fit
+   a single iteration of the smallest population, the other workers going on.
+ */
+static int
+ekRestart_plan(ekRestart* self, ekRestartPlan* plan, size_t* nbLargeRestarts, double* xMean) {
+	size_t i, minLambda;
+	int ret;
+
+	pthread_mutex_lock(&(self->mutex));
+
+	ret = 0;
+	if (!self->done) {
+		/* Pick a regime */
+		if ((self->strategy == ekRestartStrategy_IPOP) ||
+		    (*nbLargeRestarts == 0) ||
+		    (self->largeEvaluations <= self->smallEvaluations))
+			ekRestart_planLarge(self, plan, nbLargeRestarts);
+		else
+			ekRestart_planSmall(self, plan, *nbLargeRestarts);
+
+		/* Shrink the population to what is left of the budget */
+		minLambda = (self->lambdaInit < 2) ? 2 : self->lambdaInit;
+		if (plan->lambda < 2)
+			plan->lambda = 2;
+		while((plan->lambda > minLambda) && (self->nbEvaluations + plan->lambda > self->maxEvaluations))
+			plan->lambda /= 2;
+		if (plan->lambda < minLambda)
+			plan->lambda = minLambda;
+
+		if (self->nbEvaluations + plan->lambda <= self->maxEvaluations) {
+			plan->seed = ekRandomizer_next(&(self->randomizer));
+
+			if (self->lowerBound == NULL)
+				ekArrayOpsD_copy(xMean, self->xMeanInit, self->N);
+			else
+				for(i = 0; i < self->N; ++i)
+					xMean[i] = self->lowerBound[i] + (self->upperBound[i] - self->lowerBound[i]) * ekRandomizer_nextUniform(&(self->randomizer));
+
+			self->nbRestarts += 1;
+			ret = 1;
+		}
+	}
+
+	pthread_mutex_unlock(&(self->mutex));
+
+	return ret;
+}
+
+
+
+/* Takes lambda evaluations from the budget, returns 0 if not possible */
+static int
+ekRestart_reserve(ekRestart* self, const ekRestartPlan* plan) {
+	int ret;
+
+	pthread_mutex_lock(&(self->mutex));
+
+	/* A large population running out of budget does not stop the other workers */
+	ret = (!self->done) && (self->nbEvaluations + plan->lambda <= self->maxEvaluations);
+	if (ret) {
+		self->nbEvaluations += plan->lambda;
+		if (plan->isLarge)
+			self->largeEvaluations += plan->lambda;
+		else
+			self->smallEvaluations += plan->lambda;
+	}
+
+	pthread_mutex_unlock(&(self->mutex));
+
+	return ret;
+}
+
+
+
+static void
+ekRestart_report(ekRestart* self, const ekPoint* point) {
+	pthread_mutex_lock(&(self->mutex));
+
+	if (point->fitness < self->bestFitness) {
+		self->bestFitness = point->fitness;
+		ekArrayOpsD_copy(self->bestX, point->x, self->N);
+
+		if (self->bestFitness <= self->targetFitness)
+			self->done = 1;
+	}
+
+	pthread_mutex_unlock(&(self->mutex));
+}
+
+
+
+/* --- Workers ------------------------------------------------------------- */
+
+typedef struct {
+	ekRestart* restart;
+	double(*function)(const double*, size_t);
+} ekRestartJob;
+
+
+
+static void
+ekRestart_worker(void* data, size_t ESKIT_UNUSED(taskId), size_t ESKIT_UNUSED(workerId)) {
+	ekRestartJob* job;
+	ekRestart* self;
+	ekRestartPlan plan;
+	ekOptimizer optim;
+	ekDistribution distrib;
+	size_t nbLargeRestarts;
+
+	job = (ekRestartJob*)data;
+	self = job->restart;
+
+	ekOptimizer_init(&optim, self->N);
+
+	nbLargeRestarts = 0;
+	while(ekRestart_plan(self, &plan, &nbLargeRestarts, ekOptimizer_xMean(&optim))) {
+		/* Setup a fresh optimizer */
+		ekDistribution_initFromBuilder(&distrib, self->builder, self->N, plan.sigma, self->sigmaStop);
+		ekOptimizer_setDistribution(&optim, &distrib);
+		ekOptimizer_setMuLambda(&optim, plan.lambda / 2, plan.lambda);
+		ekRandomizer_seed(ekOptimizer_getRandomizer(&optim), plan.seed);
+		ekOptimizer_start(&optim);
+
+		/* Iterate until the optimizer stops, or the budget or target is reached */
+		while(ekRestart_reserve(self, &plan)) {
+			ekOptimizer_sampleCloud(&optim);
+			ekOptimizer_evaluateFunction(&optim, job->function);
+			ekOptimizer_update(&optim);
+
+			ekRestart_report(self, &ekOptimizer_bestPoint(&optim));
+
+			if (ekOptimizer_stop(&optim) != ekStopCriterionId_None)
+				break;
+		}
+
+		ekDistribution_destroy(&distrib, self->builder);
+	}
+
+	ekOptimizer_destroy(&optim);
+}
+
+
+
+void
+ekRestart_run(ekRestart* self, double(*function)(const double*, size_t)) {
+	ekRestartJob job;
+
+	self->done = 0;
+	self->nbEvaluations = 0;
+	self->nbRestarts = 0;
+	self->nbLargeRestarts = 0;
+	self->largeEvaluations = 0;
+	self->smallEvaluations = 0;
+	self->bestFitness = HUGE_VAL;
+
+	job.restart = self;
+	job.function = function;
+
+	if (self->threadPool == NULL)
+		ekRestart_worker(&job, 0, 0);
+	else
+		ekThreadPool_run(self->threadPool, ekRestart_worker, &job, ekThreadPool_nbThreads(self->threadPool));
+}
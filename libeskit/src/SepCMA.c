@@ -11,36 +11,55 @@
 #include "eskit/Macros.h"
 #include "eskit/ArrayOps.h"
 #include "eskit/SepCMA.h"
+#include "eskit/Checkpoint.h"
 #include "eskit/Optimizer.h"
 
 
 
 static void
-ekSepCMA_allocate(ekSepCMA* self, size_t N) {
+ekSepCMA_allocate(ekSepCMA* self, size_t N, ekArena* arena) {
+	self->arena = arena;
+
 	/* Allocation of vectors and matrixes */
-	self->sigmaPath = newArray(double, N);
-	self->cPath = newArray(double, N);
-	ekMatrix_init(&(self->C), N, N);
-	self->D = newArray(double, N);
+	self->sigmaPath = ekArena_newArray(arena, double, N);
+	self->cPath = ekArena_newArray(arena, double, N);
+	ekMatrix_initFromArena(&(self->C), N, N, arena);
+	self->D = ekArena_newArray(arena, double, N);
 
 	/* Allocation of temporary vectors and matrixes */
-	self->tmpVector = newArray(double, N);
+	self->tmpVector = ekArena_newArray(arena, double, N);
 }
 
 
 
 void
 ekSepCMA_init(ekSepCMA* self, size_t N) {
-	ekSepCMA_allocate(self, N);
+	ekSepCMA_initFromArena(self, N, NULL);
+}
+
+
+
+int
+ekSepCMA_initFromArena(ekSepCMA* self, size_t N, ekArena* arena) {
+	if ((arena != NULL) && (ekArena_remaining(arena) < ekSepCMA_arenaSize(N)))
+		return 0;
+
+	ekSepCMA_allocate(self, N, arena);
 	ekSepCMA_setSigma(self, 1.0, 10e-12);
 
 	self->hasCustomCov = 0;
+
+	return 1;
 }
 
 
 
 void
 ekSepCMA_destroy(ekSepCMA* self) {
+	/* Arena memory is released by its owner */
+	if (self->arena != NULL)
+		return;
+
 	free(self->sigmaPath);
 	free(self->cPath);
 	ekMatrix_destroy(&(self->C));
@@ -51,6 +70,27 @@ ekSepCMA_destroy(ekSepCMA* self) {
 
 
 
+size_t
+ekSepCMA_requiredMemory(size_t N) {
+	return 4 * N * sizeof(double) + ekMatrix_requiredMemory(N, N);
+}
+
+
+
+size_t
+ekSepCMA_memoryUsage(const ekSepCMA* self) {
+	return ekSepCMA_requiredMemory(ekMatrix_nbRows(&(self->C)));
+}
+
+
+
+size_t
+ekSepCMA_arenaSize(size_t N) {
+	return 4 * ekArena_alignedSize(N * sizeof(double)) + ekMatrix_arenaSize(N, N);
+}
+
+
+
 void
 ekSepCMA_setSigma(ekSepCMA* self, double sigmaInit, double sigmaStop) {
 	self->sigmaInit = sigmaInit;
@@ -191,19 +231,34 @@ ekSepCMA_update(ekSepCMA* self, ekOptimizer* optim) {
 
 
 static void
-ekSepCMA_sampleCloud(ekSepCMA* self, ekOptimizer* optim, ekMatrix* x, ekMatrix* z) {
-	size_t i;
+ekSepCMA_sampleBlock(void* data, ekOptimizer* optim, ekRandomizer* randomizer, ekMatrix* x, ekMatrix* z, size_t begin, size_t end) {
+	size_t i, N;
+	double *xCol, *zCol;
+	ekSepCMA* self;
 
-	/* Generate z */
-	ekMatrix_setAsGaussian(z, ekOptimizer_getRandomizer(optim), 1.0);
+	self = (ekSepCMA*)data;
+	N = ekMatrix_nbRows(x);
 
-	/* Compute x */
-	ekMatrix_copy(x, z);
-	ekMatrix_diagMul(x, self->D);
-	ekMatrix_scalarMul(x, self->sigma);
+	for(i = begin; i < end; ++i) {
+		xCol = ekMatrix_col(x, i);
+		zCol = ekMatrix_col(z, i);
+
+		/* Generate z */
+		ekArrayOpsD_gaussian(zCol, N, randomizer, 1.0);
 
-	for(i = 0; i < ekMatrix_nbCols(x); ++i)
-		ekArrayOpsD_inc(ekMatrix_col(x, i), ekOptimizer_xMean(optim), ekMatrix_nbRows(x));
+		/* Compute x */
+		ekArrayOpsD_copy(xCol, zCol, N);
+		ekArrayOpsD_convolve(xCol, self->D, N);
+		ekArrayOpsD_scalarMul(xCol, N, self->sigma);
+		ekArrayOpsD_inc(xCol, ekOptimizer_xMean(optim), N);
+	}
+}
+
+
+
+static void
+ekSepCMA_sampleCloud(ekSepCMA* self, ekOptimizer* optim, ekMatrix* x, ekMatrix* z) {
+	ekOptimizer_sampleBlocks(optim, x, z, ekSepCMA_sampleBlock, self);
 }
 
 
@@ -260,6 +315,57 @@ ekSepCMA_stop(ekSepCMA* self, ekOptimizer* optim) {
 
 
 
+static int
+ekSepCMA_save(ekSepCMA* self, ekOptimizer* optim, FILE* file) {
+	size_t N;
+
+	N = ekOptimizer_N(optim);
+
+	return
+		ekCheckpoint_writeDouble(file, self->sigmaInit) &&
+		ekCheckpoint_writeDouble(file, self->sigmaStop) &&
+		ekCheckpoint_writeDouble(file, self->sigma) &&
+		ekCheckpoint_write(file, &(self->constants), sizeof(ekCMAConstants)) &&
+		ekCheckpoint_writeArray(file, self->sigmaPath, N) &&
+		ekCheckpoint_writeArray(file, self->cPath, N) &&
+		ekCheckpoint_writeMatrix(file, &(self->C)) &&
+		ekCheckpoint_writeArray(file, self->D, N);
+}
+
+
+
+static int
+ekSepCMA_load(ekSepCMA* self, ekOptimizer* optim, FILE* file) {
+	size_t N;
+
+	N = ekOptimizer_N(optim);
+
+	self->hasCustomCov = 0;
+	return
+		ekCheckpoint_readDouble(file, &(self->sigmaInit)) &&
+		ekCheckpoint_readDouble(file, &(self->sigmaStop)) &&
+		ekCheckpoint_readDouble(file, &(self->sigma)) &&
+		ekCheckpoint_read(file, &(self->constants), sizeof(ekCMAConstants)) &&
+		ekCheckpoint_readArray(file, self->sigmaPath, N) &&
+		ekCheckpoint_readArray(file, self->cPath, N) &&
+		ekCheckpoint_readMatrix(file, &(self->C)) &&
+		ekCheckpoint_readArray(file, self->D, N);
+}
+
+
+
+static void
+ekSepCMA_project(ekSepCMA* self, ekOptimizer* optim, const double* x, double* z) {
+	size_t i, N;
+
+	N = ekOptimizer_N(optim);
+
+	for(i = 0; i < N; ++i)
+		z[i] = (self->D[i] > 0.0) ? (x[i] - ekOptimizer_xMean(optim)[i]) / (self->sigma * self->D[i]) : 0.0;
+}
+
+
+
 /* --- ekSepCMA delegate ----------------------------------------------------- */
 
 static void
@@ -297,6 +403,39 @@ ekSepCMA_delegate_stop(ekDistribution* self, ekOptimizer* optim) {
 
 
 
+static int
+ekSepCMA_delegate_save(ekDistribution* self, ekOptimizer* optim, FILE* file) {
+	return ekSepCMA_save((ekSepCMA*)self->data, optim, file);
+}
+
+
+
+static int
+ekSepCMA_delegate_load(ekDistribution* self, ekOptimizer* optim, FILE* file) {
+	return ekSepCMA_load((ekSepCMA*)self->data, optim, file);
+}
+
+
+
+static void
+ekSepCMA_delegate_view(ekDistribution* self, ekOptimizer* optim, ekGenerationView* view) {
+	ekSepCMA* distrib;
+
+	distrib = (ekSepCMA*)self->data;
+	view->sigma = distrib->sigma;
+	view->DMin = ekArrayOpsD_min(distrib->D, ekOptimizer_N(optim));
+	view->DMax = ekArrayOpsD_max(distrib->D, ekOptimizer_N(optim));
+}
+
+
+
+static void
+ekSepCMA_delegate_project(ekDistribution* self, ekOptimizer* optim, const double* x, double* z) {
+	ekSepCMA_project((ekSepCMA*)self->data, optim, x, z);
+}
+
+
+
 const ekDistributionDelegate 
 ekSepCMA_DistributionDelegate =
 {
@@ -305,5 +444,9 @@ ekSepCMA_DistributionDelegate =
 	ekSepCMA_delegate_update,
 	ekSepCMA_delegate_samplePoint,
 	ekSepCMA_delegate_sampleCloud,
-	ekSepCMA_delegate_stop
+	ekSepCMA_delegate_stop,
+	ekSepCMA_delegate_save,
+	ekSepCMA_delegate_load,
+	ekSepCMA_delegate_view,
+	ekSepCMA_delegate_project
 };
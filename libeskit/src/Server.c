@@ -0,0 +1,858 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "eskit/Macros.h"
+#include "eskit/Socket.h"
+#include "eskit/Optimizer.h"
+#include "eskit/OptimizerPool.h"
+#include "eskit/DistributionBuilder.h"
+#include "eskit/Server.h"
+
+
+
+enum ekServerMessage {
+	ekServerMessage_Hello = 0,
+	ekServerMessage_Open,
+	ekServerMessage_Ask,
+	ekServerMessage_Tell,
+	ekServerMessage_Close,
+	ekServerMessage_Opened,
+	ekServerMessage_Points,
+	ekServerMessage_Closed,
+	ekServerMessage_Error
+};
+
+
+
+enum ekServerSessionState {
+	ekServerSessionState_Free = 0,
+	ekServerSessionState_Started,        /* Not sampled yet                  */
+	ekServerSessionState_Sampled,        /* Points waiting for a tell        */
+	ekServerSessionState_Stopped
+};
+
+
+
+struct s_ekServerLink {
+	int fd;
+	uint32_t id;
+	int ready;                           /* Set once the client hello is received */
+	int lost;                            /* Removed at the end of the batch  */
+	ekSocketBuffer in, out;
+};
+
+
+
+struct s_ekServerSession {
+	uint32_t owner;                      /* Id of the link of the client     */
+	enum ekServerSessionState state;
+	enum ekStopCriterionId stop;
+	size_t iteration;                    /* Last batch with a request        */
+	ekOptimizer* optim;
+	ekOptimizerPool* pool;
+};
+
+
+
+struct s_ekServerPool {
+	const ekDistributionBuilder* builder;
+	double sigmaInit;
+	double sigmaStop;
+	ekOptimizerPool pool;
+};
+
+
+
+/* A request, answered once the batch is done */
+struct s_ekServerJob {
+	size_t link;
+	enum ekServerMessage reply;
+	uint32_t session;
+	enum ekServerError error;
+	int step;                            /* 0, or 1 to sample, 2 to update then sample */
+};
+
+
+
+static const ekDistributionBuilder* ekServer_builders[] = {
+	&ekCSA_DistributionBuilder,
+	&ekCMA_DistributionBuilder,
+	&ekSepCMA_DistributionBuilder
+};
+
+
+
+/* --- Server -------------------------------------------------------------- */
+
+int
+ekServer_init(ekServer* self, const char* address) {
+	self->listenFd = ekSocket_listen(address, &(self->unixPath));
+	if (self->listenFd < 0)
+		return 0;
+
+	self->threadPool = NULL;
+	self->maxSessions = 65536;
+	self->maxN = 1024;
+	self->maxLambda = 1024;
+
+	self->links = NULL;
+	self->nbLinks = 0;
+	self->linksCapacity = 0;
+	self->nextLinkId = 1;
+	self->fds = new(struct pollfd);
+
+	self->sessions = NULL;
+	self->sessionsCapacity = 0;
+	self->freeSessions = NULL;
+	self->nbFreeSessions = 0;
+
+	self->pools = NULL;
+	self->nbPools = 0;
+
+	self->jobs = NULL;
+	self->nbJobs = 0;
+	self->jobsCapacity = 0;
+	self->iteration = 0;
+	self->backlog = 0;
+	self->fitnesses = newArray(double, self->maxLambda);
+
+	self->nbSessions = 0;
+	self->nbSteps = 0;
+	self->nbBatches = 0;
+
+	return 1;
+}
+
+
+
+static void
+ekServer_releaseSession(ekServer* self, uint32_t id) {
+	struct s_ekServerSession* session;
+
+	session = self->sessions + id;
+	ekOptimizerPool_release(session->pool, session->optim);
+	session->state = ekServerSessionState_Free;
+	session->owner = 0;
+
+	self->freeSessions[self->nbFreeSessions] = id;
+	self->nbFreeSessions += 1;
+	self->nbSessions -= 1;
+}
+
+
+
+static void
+ekServer_closeLink(ekServer* self, struct s_ekServerLink* link) {
+	size_t i;
+
+	for(i = 0; i < self->sessionsCapacity; ++i)
+		if ((self->sessions[i].state != ekServerSessionState_Free) && (self->sessions[i].owner == link->id))
+			ekServer_releaseSession(self, i);
+
+	close(link->fd);
+	ekSocketBuffer_destroy(&(link->in));
+	ekSocketBuffer_destroy(&(link->out));
+}
+
+
+
+void
+ekServer_destroy(ekServer* self) {
+	size_t i;
+
+	for(i = 0; i < self->nbLinks; ++i)
+		ekServer_closeLink(self, self->links + i);
+
+	for(i = 0; i < self->nbPools; ++i) {
+		ekOptimizerPool_destroy(&(self->pools[i]->pool));
+		free(self->pools[i]);
+	}
+
+	close(self->listenFd);
+	if (self->unixPath != NULL) {
+		unlink(self->unixPath);
+		free(self->unixPath);
+	}
+
+	free(self->links);
+	free(self->fds);
+	free(self->sessions);
+	free(self->freeSessions);
+	free(self->pools);
+	free(self->jobs);
+	free(self->fitnesses);
+}
+
+
+
+void
+ekServer_setThreadPool(ekServer* self, ekThreadPool* pool) {
+	self->threadPool = pool;
+}
+
+
+
+void
+ekServer_setLimits(ekServer* self, size_t maxSessions, size_t maxN, size_t maxLambda) {
+	self->maxSessions = maxSessions;
+	self->maxN = maxN;
+	self->maxLambda = maxLambda;
+
+	free(self->fitnesses);
+	self->fitnesses = newArray(double, maxLambda);
+}
+
+
+
+static void
+ekServer_accept(ekServer* self) {
+	int fd;
+	struct s_ekServerLink* link;
+
+	while(1) {
+		fd = ekSocket_accept(self->listenFd);
+		if (fd < 0)
+			return;
+
+		if (self->nbLinks == self->linksCapacity) {
+			self->linksCapacity = (self->linksCapacity > 0) ? 2 * self->linksCapacity : 8;
+			self->links = (struct s_ekServerLink*)realloc(self->links, self->linksCapacity * sizeof(struct s_ekServerLink));
+			self->fds = (struct pollfd*)realloc(self->fds, (self->linksCapacity + 1) * sizeof(struct pollfd));
+		}
+
+		link = self->links + self->nbLinks;
+		self->nbLinks += 1;
+
+		memset(link, 0, sizeof(*link));
+		link->fd = fd;
+		link->id = self->nextLinkId;
+		self->nextLinkId = (self->nextLinkId == UINT32_MAX) ? 1 : self->nextLinkId + 1;
+
+		ekSocket_putHeader(ekSocketBuffer_reserve(&(link->out), ESKIT_SOCKET_HEADER_SIZE), ekServerMessage_Hello, ESKIT_SERVER_MAGIC, ESKIT_SERVER_VERSION, self->maxN);
+		link->out.end += ESKIT_SOCKET_HEADER_SIZE;
+	}
+}
+
+
+
+/* --- Requests ------------------------------------------------------------ */
+
+static void
+ekServer_addJob(ekServer* self, size_t link, enum ekServerMessage reply, uint32_t session, enum ekServerError error, int step) {
+	struct s_ekServerJob* job;
+
+	if (self->nbJobs == self->jobsCapacity) {
+		self->jobsCapacity = (self->jobsCapacity > 0) ? 2 * self->jobsCapacity : 64;
+		self->jobs = (struct s_ekServerJob*)realloc(self->jobs, self->jobsCapacity * sizeof(struct s_ekServerJob));
+	}
+
+	job = self->jobs + self->nbJobs;
+	self->nbJobs += 1;
+
+	job->link = link;
+	job->reply = reply;
+	job->session = session;
+	job->error = error;
+	job->step = step;
+}
+
+
+
+/* The pool of a distribution and of its sigmas, created on first use */
+static ekOptimizerPool*
+ekServer_pool(ekServer* self, const ekDistributionBuilder* builder, double sigmaInit, double sigmaStop) {
+	size_t i;
+	struct s_ekServerPool* pool;
+
+	for(i = 0; i < self->nbPools; ++i) {
+		pool = self->pools[i];
+		if ((pool->builder == builder) && (pool->sigmaInit == sigmaInit) && (pool->sigmaStop == sigmaStop))
+			return &(pool->pool);
+	}
+
+	pool = new(struct s_ekServerPool);
+	pool->builder = builder;
+	pool->sigmaInit = sigmaInit;
+	pool->sigmaStop = sigmaStop;
+	ekOptimizerPool_init(&(pool->pool), builder, sigmaInit, sigmaStop);
+
+	self->pools = (struct s_ekServerPool**)realloc(self->pools, (self->nbPools + 1) * sizeof(struct s_ekServerPool*));
+	self->pools[self->nbPools] = pool;
+	self->nbPools += 1;
+
+	return &(pool->pool);
+}
+
+
+
+static uint32_t
+ekServer_newSession(ekServer* self) {
+	size_t i, capacity;
+
+	if (self->nbFreeSessions == 0) {
+		capacity = (self->sessionsCapacity > 0) ? 2 * self->sessionsCapacity : 64;
+		if (capacity > self->maxSessions)
+			capacity = self->maxSessions;
+
+		self->sessions = (struct s_ekServerSession*)realloc(self->sessions, capacity * sizeof(struct s_ekServerSession));
+		self->freeSessions = (uint32_t*)realloc(self->freeSessions, capacity * sizeof(uint32_t));
+
+		/* Backwards, so that the lowest ids are handed out first */
+		for(i = capacity; i > self->sessionsCapacity; --i) {
+			self->sessions[i - 1].state = ekServerSessionState_Free;
+			self->sessions[i - 1].owner = 0;
+			self->freeSessions[self->nbFreeSessions] = i - 1;
+			self->nbFreeSessions += 1;
+		}
+		self->sessionsCapacity = capacity;
+	}
+
+	self->nbFreeSessions -= 1;
+	self->nbSessions += 1;
+
+	return self->freeSessions[self->nbFreeSessions];
+}
+
+
+
+static void
+ekServer_open(ekServer* self, size_t linkIndex, const unsigned char* p) {
+	size_t i, N, lambda;
+	uint32_t id, distribution;
+	double sigmaInit, sigmaStop, seed;
+	double* xMean;
+	struct s_ekServerSession* session;
+
+	N = ekSocket_getU32(p + 4);
+	lambda = ekSocket_getU32(p + 8);
+	distribution = ekSocket_getU32(p + 12);
+
+	p += ESKIT_SOCKET_HEADER_SIZE;
+	sigmaInit = ekSocket_getF64(p);
+	sigmaStop = ekSocket_getF64(p + 8);
+	seed = ekSocket_getF64(p + 16);
+
+	if (lambda == 0)
+		lambda = 4.0 + 3.0 * log((double)N);
+
+	if ((lambda < 2) || (lambda > self->maxLambda) ||
+	    (distribution >= sizeof(ekServer_builders) / sizeof(ekServer_builders[0])) ||
+	    (!(sigmaInit > 0.0)) || (!(sigmaStop >= 0.0)) || (!(seed >= 0.0)) || (seed > UINT32_MAX)) {
+		ekServer_addJob(self, linkIndex, ekServerMessage_Error, 0, ekServerError_BadParameters, 0);
+		return;
+	}
+
+	if (self->nbSessions == self->maxSessions) {
+		ekServer_addJob(self, linkIndex, ekServerMessage_Error, 0, ekServerError_TooManySessions, 0);
+		return;
+	}
+
+	id = ekServer_newSession(self);
+	session = self->sessions + id;
+	session->owner = self->links[linkIndex].id;
+	session->state = ekServerSessionState_Started;
+	session->stop = ekStopCriterionId_None;
+	session->iteration = self->iteration;
+	session->pool = ekServer_pool(self, ekServer_builders[distribution], sigmaInit, sigmaStop);
+	session->optim = ekOptimizerPool_acquire(session->pool, N, lambda);
+
+	ekRandomizer_seed(ekOptimizer_getRandomizer(session->optim), (uint32_t)seed);
+
+	xMean = ekOptimizer_xMean(session->optim);
+	for(i = 0, p += 24; i < N; ++i, p += 8)
+		xMean[i] = ekSocket_getF64(p);
+
+	ekOptimizer_start(session->optim);
+
+	ekServer_addJob(self, linkIndex, ekServerMessage_Opened, id, 0, 0);
+}
+
+
+
+/* Returns the session of a client, or NULL if the client does not own it */
+static struct s_ekServerSession*
+ekServer_session(ekServer* self, size_t linkIndex, uint32_t id) {
+	if ((id >= self->sessionsCapacity) || (self->sessions[id].state == ekServerSessionState_Free) || (self->sessions[id].owner != self->links[linkIndex].id))
+		return NULL;
+
+	return self->sessions + id;
+}
+
+
+
+/*
+   Handles the complete requests received on a link, returns 0 if the link
+   should be dropped. A request on a session already in the batch is left
+   for the next batch, with the requests after it.
+ */
+static int
+ekServer_receive(ekServer* self, size_t linkIndex) {
+	size_t i, size, count;
+	uint32_t type, id;
+	const unsigned char* p;
+	struct s_ekServerLink* link;
+	struct s_ekServerSession* session;
+
+	link = self->links + linkIndex;
+	while(ekSocketBuffer_size(&(link->in)) >= ESKIT_SOCKET_HEADER_SIZE) {
+		p = ekSocketBuffer_front(&(link->in));
+		type = ekSocket_getU32(p);
+		id = ekSocket_getU32(p + 4);
+		count = ekSocket_getU32(p + 8);
+
+		if (!link->ready) {
+			if ((type != ekServerMessage_Hello) || (id != ESKIT_SERVER_MAGIC) || (count != ESKIT_SERVER_VERSION))
+				return 0;
+			link->ready = 1;
+			link->in.begin += ESKIT_SOCKET_HEADER_SIZE;
+			continue;
+		}
+
+		/* The size of a request is checked before waiting for all of it */
+		if (type == ekServerMessage_Open) {
+			if ((id == 0) || (id > self->maxN))
+				return 0;
+			size = ESKIT_SOCKET_HEADER_SIZE + 8 * (3 + id);
+		}
+		else if (type == ekServerMessage_Tell) {
+			if (count > self->maxLambda)
+				return 0;
+			size = ESKIT_SOCKET_HEADER_SIZE + 8 * count;
+		}
+		else if ((type == ekServerMessage_Ask) || (type == ekServerMessage_Close))
+			size = ESKIT_SOCKET_HEADER_SIZE;
+		else
+			return 0;
+
+		if (ekSocketBuffer_size(&(link->in)) < size)
+			break;
+
+		if (type == ekServerMessage_Open) {
+			ekServer_open(self, linkIndex, p);
+			link->in.begin += size;
+			continue;
+		}
+
+		session = ekServer_session(self, linkIndex, id);
+		if (session == NULL) {
+			ekServer_addJob(self, linkIndex, ekServerMessage_Error, id, ekServerError_UnknownSession, 0);
+			link->in.begin += size;
+			continue;
+		}
+
+		if (session->iteration == self->iteration) {
+			self->backlog = 1;
+			break;
+		}
+		session->iteration = self->iteration;
+
+		switch(type) {
+			case ekServerMessage_Ask:
+				if (session->state == ekServerSessionState_Started)
+					ekServer_addJob(self, linkIndex, ekServerMessage_Points, id, 0, 1);
+				else
+					ekServer_addJob(self, linkIndex, ekServerMessage_Points, id, 0, 0);
+				break;
+
+			case ekServerMessage_Tell:
+				if (session->state != ekServerSessionState_Sampled) {
+					ekServer_addJob(self, linkIndex, ekServerMessage_Error, id, ekServerError_BadState, 0);
+					break;
+				}
+				if (count != ekOptimizer_lambda(session->optim))
+					return 0;
+
+				for(i = 0, p += ESKIT_SOCKET_HEADER_SIZE; i < count; ++i, p += 8)
+					self->fitnesses[i] = ekSocket_getF64(p);
+				ekOptimizer_setFitnesses(session->optim, self->fitnesses);
+
+				ekServer_addJob(self, linkIndex, ekServerMessage_Points, id, 0, 2);
+				break;
+
+			default:
+				ekServer_releaseSession(self, id);
+				ekServer_addJob(self, linkIndex, ekServerMessage_Closed, id, 0, 0);
+		}
+
+		link->in.begin += size;
+	}
+
+	return 1;
+}
+
+
+
+/* --- Batch --------------------------------------------------------------- */
+
+static void
+ekServer_step(void* data, size_t begin, size_t end, size_t ESKIT_UNUSED(workerId)) {
+	ekServer* self;
+	struct s_ekServerJob* job;
+	struct s_ekServerSession* session;
+
+	self = (ekServer*)data;
+	for(job = self->jobs + begin; job != self->jobs + end; ++job) {
+		if (job->step == 0)
+			continue;
+
+		session = self->sessions + job->session;
+		if (job->step == 2) {
+			ekOptimizer_update(session->optim);
+			session->stop = ekOptimizer_stop(session->optim);
+		}
+
+		if (session->stop == ekStopCriterionId_None) {
+			ekOptimizer_sampleCloud(session->optim);
+			session->state = ekServerSessionState_Sampled;
+		}
+		else
+			session->state = ekServerSessionState_Stopped;
+	}
+}
+
+
+
+static void
+ekServer_sendPoints(ekServer* self, struct s_ekServerLink* link, uint32_t id) {
+	size_t i, j, N, count;
+	const double *x, *bestX;
+	double bestFitness;
+	unsigned char* p;
+	ekOptimizer* optim;
+
+	optim = self->sessions[id].optim;
+	N = ekOptimizer_N(optim);
+	count = (self->sessions[id].state == ekServerSessionState_Sampled) ? ekOptimizer_lambda(optim) : 0;
+
+	/* No best point before the first update */
+	if (ekOptimizer_nbUpdates(optim) > 0) {
+		bestFitness = ekOptimizer_bestPoint(optim).fitness;
+		bestX = ekOptimizer_bestPoint(optim).x;
+	}
+	else {
+		bestFitness = HUGE_VAL;
+		bestX = ekOptimizer_xMean(optim);
+	}
+
+	p = ekSocketBuffer_reserve(&(link->out), ESKIT_SOCKET_HEADER_SIZE + 8 * (1 + N + count * N));
+	link->out.end += ESKIT_SOCKET_HEADER_SIZE + 8 * (1 + N + count * N);
+
+	ekSocket_putHeader(p, ekServerMessage_Points, id, self->sessions[id].stop, count);
+	p += ESKIT_SOCKET_HEADER_SIZE;
+
+	ekSocket_putF64(p, bestFitness);
+	for(j = 0, p += 8; j < N; ++j, p += 8)
+		ekSocket_putF64(p, bestX[j]);
+
+	for(i = 0; i < count; ++i) {
+		x = optim->pointArray[i].x;
+		for(j = 0; j < N; ++j, p += 8)
+			ekSocket_putF64(p, x[j]);
+	}
+}
+
+
+
+static void
+ekServer_reply(ekServer* self) {
+	size_t i;
+	unsigned char* p;
+	struct s_ekServerJob* job;
+	struct s_ekServerLink* link;
+
+	for(i = 0; i < self->nbJobs; ++i) {
+		job = self->jobs + i;
+		link = self->links + job->link;
+		if (link->lost)
+			continue;
+
+		if (job->reply == ekServerMessage_Points) {
+			ekServer_sendPoints(self, link, job->session);
+			continue;
+		}
+
+		p = ekSocketBuffer_reserve(&(link->out), ESKIT_SOCKET_HEADER_SIZE);
+		link->out.end += ESKIT_SOCKET_HEADER_SIZE;
+
+		if (job->reply == ekServerMessage_Opened)
+			ekSocket_putHeader(p, ekServerMessage_Opened, job->session, ekOptimizer_lambda(self->sessions[job->session].optim), 0);
+		else if (job->reply == ekServerMessage_Closed)
+			ekSocket_putHeader(p, ekServerMessage_Closed, job->session, 0, 0);
+		else
+			ekSocket_putHeader(p, ekServerMessage_Error, job->error, job->session, 0);
+	}
+}
+
+
+
+int
+ekServer_poll(ekServer* self, double timeout) {
+	int ret;
+	size_t i, nbSteps;
+	struct s_ekServerLink* link;
+
+	self->fds[0].fd = self->listenFd;
+	self->fds[0].events = POLLIN;
+	for(i = 0; i < self->nbLinks; ++i) {
+		link = self->links + i;
+		self->fds[i + 1].fd = link->fd;
+		self->fds[i + 1].events = POLLIN | ((link->out.begin < link->out.end) ? POLLOUT : 0);
+	}
+
+	/* Requests left by the last batch are handled at once */
+	ret = poll(self->fds, self->nbLinks + 1, self->backlog ? 0 : ((timeout < HUGE_VAL) ? (int)ceil(1e3 * timeout) : -1));
+	if ((ret < 0) || ((ret == 0) && (!self->backlog)))
+		return 0;
+
+	self->iteration += 1;
+	self->backlog = 0;
+	self->nbJobs = 0;
+
+	for(i = 0; i < self->nbLinks; ++i) {
+		link = self->links + i;
+
+		if (self->fds[i + 1].revents & POLLOUT)
+			link->lost = !ekSocket_flush(link->fd, &(link->out));
+
+		if ((!link->lost) && (self->fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+			link->lost = !ekSocket_read(link->fd, &(link->in));
+
+		if ((!link->lost) && (ekSocketBuffer_size(&(link->in)) > 0))
+			link->lost = !ekServer_receive(self, i);
+	}
+
+	/* All the sessions to sample or to update, in a single batch */
+	for(i = 0, nbSteps = 0; i < self->nbJobs; ++i)
+		nbSteps += (self->jobs[i].step != 0);
+
+	if (nbSteps > 0) {
+		if (self->threadPool != NULL)
+			ekThreadPool_runRange(self->threadPool, ekServer_step, self, self->nbJobs, 1);
+		else
+			ekServer_step(self, 0, self->nbJobs, 0);
+
+		self->nbSteps += nbSteps;
+		self->nbBatches += 1;
+	}
+
+	ekServer_reply(self);
+
+	/* Backwards, since the lost links are swapped with the last one */
+	for(i = self->nbLinks; i > 0; --i) {
+		link = self->links + i - 1;
+		if ((!link->lost) && (link->out.begin < link->out.end))
+			link->lost = !ekSocket_flush(link->fd, &(link->out));
+
+		if (link->lost) {
+			ekServer_closeLink(self, link);
+			self->nbLinks -= 1;
+			*link = self->links[self->nbLinks];
+		}
+	}
+
+	if (self->fds[0].revents & POLLIN)
+		ekServer_accept(self);
+
+	return 1;
+}
+
+
+
+/* --- Client -------------------------------------------------------------- */
+
+static unsigned char*
+ekServerClient_reserve(ekServerClient* self, size_t size) {
+	if (self->capacity < size) {
+		self->capacity = size;
+		self->buffer = (unsigned char*)realloc(self->buffer, size);
+	}
+
+	return self->buffer;
+}
+
+
+
+int
+ekServerClient_connect(ekServerClient* self, const char* address) {
+	unsigned char header[ESKIT_SOCKET_HEADER_SIZE];
+
+	self->fd = ekSocket_connect(address);
+	if (self->fd < 0)
+		return 0;
+
+	ekSocket_putHeader(header, ekServerMessage_Hello, ESKIT_SERVER_MAGIC, ESKIT_SERVER_VERSION, 0);
+	if ((!ekSocket_sendAll(self->fd, header, sizeof(header))) ||
+	    (!ekSocket_recvAll(self->fd, header, sizeof(header))) ||
+	    (ekSocket_getU32(header) != ekServerMessage_Hello) ||
+	    (ekSocket_getU32(header + 4) != ESKIT_SERVER_MAGIC) ||
+	    (ekSocket_getU32(header + 8) != ESKIT_SERVER_VERSION)) {
+		close(self->fd);
+		return 0;
+	}
+
+	self->maxN = ekSocket_getU32(header + 12);
+	self->buffer = NULL;
+	self->capacity = 0;
+
+	return 1;
+}
+
+
+
+void
+ekServerClient_disconnect(ekServerClient* self) {
+	close(self->fd);
+	free(self->buffer);
+}
+
+
+
+/* Receives the reply header, returns its type, or -1 if the link is lost */
+static int
+ekServerSession_receive(ekServerSession* self, unsigned char* header) {
+	if (!ekSocket_recvAll(self->client->fd, header, ESKIT_SOCKET_HEADER_SIZE))
+		return -1;
+
+	if (ekSocket_getU32(header) == ekServerMessage_Error)
+		self->error = (enum ekServerError)ekSocket_getU32(header + 4);
+
+	return (int)ekSocket_getU32(header);
+}
+
+
+
+int
+ekServerSession_open(ekServerSession* self, ekServerClient* client, enum ekServerDistribution distribution, size_t N, size_t lambda, double sigmaInit, double sigmaStop, uint32_t seed, const double* xMeanInit) {
+	size_t i, size;
+	unsigned char* p;
+	unsigned char header[ESKIT_SOCKET_HEADER_SIZE];
+
+	self->client = client;
+	self->error = 0;
+	if ((N == 0) || (N > client->maxN)) {
+		self->error = ekServerError_BadParameters;
+		return 0;
+	}
+
+	size = ESKIT_SOCKET_HEADER_SIZE + 8 * (3 + N);
+	p = ekServerClient_reserve(client, size);
+
+	ekSocket_putHeader(p, ekServerMessage_Open, N, lambda, distribution);
+	p += ESKIT_SOCKET_HEADER_SIZE;
+	ekSocket_putF64(p, sigmaInit);
+	ekSocket_putF64(p + 8, sigmaStop);
+	ekSocket_putF64(p + 16, seed);
+	for(i = 0, p += 24; i < N; ++i, p += 8)
+		ekSocket_putF64(p, (xMeanInit != NULL) ? xMeanInit[i] : 0.0);
+
+	if ((!ekSocket_sendAll(client->fd, client->buffer, size)) || (ekServerSession_receive(self, header) != ekServerMessage_Opened))
+		return 0;
+
+	self->id = ekSocket_getU32(header + 4);
+	self->N = N;
+	self->lambda = ekSocket_getU32(header + 8);
+	self->sampled = 0;
+	self->stop = ekStopCriterionId_None;
+	self->bestFitness = HUGE_VAL;
+	self->bestX = newArray(double, N);
+	self->points = newArray(double, self->lambda * N);
+
+	return 1;
+}
+
+
+
+static int
+ekServerSession_receivePoints(ekServerSession* self) {
+	size_t i, count, size;
+	const unsigned char* p;
+	unsigned char header[ESKIT_SOCKET_HEADER_SIZE];
+
+	if ((ekServerSession_receive(self, header) != ekServerMessage_Points) || (ekSocket_getU32(header + 4) != self->id))
+		return 0;
+
+	count = ekSocket_getU32(header + 12);
+	if ((count != 0) && (count != self->lambda))
+		return 0;
+
+	size = 8 * (1 + self->N + count * self->N);
+	if (!ekSocket_recvAll(self->client->fd, ekServerClient_reserve(self->client, size), size))
+		return 0;
+
+	p = self->client->buffer;
+	self->stop = (enum ekStopCriterionId)ekSocket_getU32(header + 8);
+	self->bestFitness = ekSocket_getF64(p);
+	for(i = 0, p += 8; i < self->N; ++i, p += 8)
+		self->bestX[i] = ekSocket_getF64(p);
+	for(i = 0; i < count * self->N; ++i, p += 8)
+		self->points[i] = ekSocket_getF64(p);
+
+	self->sampled = (count > 0);
+
+	return 1;
+}
+
+
+
+const double*
+ekServerSession_ask(ekServerSession* self) {
+	unsigned char header[ESKIT_SOCKET_HEADER_SIZE];
+
+	if ((!self->sampled) && (self->stop == ekStopCriterionId_None)) {
+		ekSocket_putHeader(header, ekServerMessage_Ask, self->id, 0, 0);
+		if ((!ekSocket_sendAll(self->client->fd, header, sizeof(header))) || (!ekServerSession_receivePoints(self)))
+			return NULL;
+	}
+
+	return self->sampled ? self->points : NULL;
+}
+
+
+
+int
+ekServerSession_tell(ekServerSession* self, const double* fitnesses) {
+	size_t i, size;
+	unsigned char* p;
+
+	if (!self->sampled)
+		return 0;
+
+	size = ESKIT_SOCKET_HEADER_SIZE + 8 * self->lambda;
+	p = ekServerClient_reserve(self->client, size);
+
+	ekSocket_putHeader(p, ekServerMessage_Tell, self->id, self->lambda, 0);
+	for(i = 0, p += ESKIT_SOCKET_HEADER_SIZE; i < self->lambda; ++i, p += 8)
+		ekSocket_putF64(p, fitnesses[i]);
+
+	self->sampled = 0;
+	if (!ekSocket_sendAll(self->client->fd, self->client->buffer, size))
+		return 0;
+
+	return ekServerSession_receivePoints(self);
+}
+
+
+
+void
+ekServerSession_close(ekServerSession* self) {
+	unsigned char header[ESKIT_SOCKET_HEADER_SIZE];
+
+	/* Best effort, the server closes the sessions of a lost client anyway */
+	ekSocket_putHeader(header, ekServerMessage_Close, self->id, 0, 0);
+	if (ekSocket_sendAll(self->client->fd, header, sizeof(header)))
+		ekServerSession_receive(self, header);
+
+	free(self->bestX);
+	free(self->points);
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "eskit/Optimizer.h"
+#include "eskit/SharedChannel.h"
+
+
+
+static int
+ekSharedChannel_map(ekSharedChannel* self, int fd, size_t size) {
+	self->shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (self->shared == MAP_FAILED) {
+		self->shared = NULL;
+		return 0;
+	}
+
+	self->sharedSize = size;
+	self->header = (ekSharedChannelHeader*)self->shared;
+	return 1;
+}
+
+
+
+int
+ekSharedChannel_create(ekSharedChannel* self, const char* name, size_t N, size_t lambdaMax) {
+	int fd;
+	size_t headerSize, fitnessSize, size;
+	ekSharedChannelHeader* header;
+
+	headerSize = ekArena_alignedSize(sizeof(ekSharedChannelHeader));
+	fitnessSize = ekArena_alignedSize(lambdaMax * sizeof(double));
+	size = headerSize + fitnessSize + ekOptimizer_arenaSize(N, lambdaMax);
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+	if (fd < 0)
+		return 0;
+
+	if (ftruncate(fd, size) != 0) {
+		close(fd);
+		shm_unlink(name);
+		return 0;
+	}
+
+	if (!ekSharedChannel_map(self, fd, size)) {
+		shm_unlink(name);
+		return 0;
+	}
+
+	self->name = strdup(name);
+	self->owner = 1;
+	self->generation = 0;
+
+	header = self->header;
+	header->magic = ESKIT_SHARED_CHANNEL_MAGIC;
+	header->closed = 0;
+	header->N = N;
+	header->lambdaMax = lambdaMax;
+	header->lambda = 0;
+	header->generation = 0;
+	header->fitnessGeneration = 0;
+	header->xOffset = 0;
+	header->fitnessOffset = headerSize;
+	ekDoorbell_init(&(header->askBell));
+	ekDoorbell_init(&(header->tellBell));
+
+	self->fitnesses = (double*)((char*)self->shared + headerSize);
+	ekArena_init(&(self->arena), (char*)self->shared + headerSize + fitnessSize, size - headerSize - fitnessSize);
+
+	return 1;
+}
+
+
+
+int
+ekSharedChannel_open(ekSharedChannel* self, const char* name) {
+	int fd;
+	struct stat info;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+		return 0;
+
+	if ((fstat(fd, &info) != 0) || ((size_t)info.st_size < sizeof(ekSharedChannelHeader))) {
+		close(fd);
+		return 0;
+	}
+
+	if (!ekSharedChannel_map(self, fd, info.st_size))
+		return 0;
+
+	if (self->header->magic != ESKIT_SHARED_CHANNEL_MAGIC) {
+		munmap(self->shared, self->sharedSize);
+		return 0;
+	}
+
+	self->name = strdup(name);
+	self->owner = 0;
+	self->fitnesses = (double*)((char*)self->shared + self->header->fitnessOffset);
+
+	/* A generation published but not told yet is still to be evaluated */
+	ekDoorbell_lock(&(self->header->tellBell));
+	self->generation = self->header->fitnessGeneration;
+	ekDoorbell_unlock(&(self->header->tellBell));
+
+	return 1;
+}
+
+
+
+void
+ekSharedChannel_destroy(ekSharedChannel* self) {
+	/* The doorbells are left as is, the other side may be waiting on them */
+	if (self->owner) {
+		ekDoorbell_lock(&(self->header->askBell));
+		self->header->closed = 1;
+		ekDoorbell_unlock(&(self->header->askBell));
+		ekDoorbell_ring(&(self->header->askBell));
+
+		shm_unlink(self->name);
+	}
+
+	munmap(self->shared, self->sharedSize);
+	free(self->name);
+}
+
+
+
+int
+ekSharedChannel_initOptimizer(ekSharedChannel* self, ekOptimizer* optim) {
+	if (!ekOptimizer_initFromArena(optim, self->header->N, self->header->lambdaMax, &(self->arena)))
+		return 0;
+
+	self->header->xOffset = (uint64_t)((char*)optim->X.tuple - (char*)self->shared);
+	return 1;
+}
+
+
+
+int
+ekSharedChannel_evaluate(ekSharedChannel* self, ekOptimizer* optim, double timeout) {
+	int done;
+	uint32_t count, current;
+	ekSharedChannelHeader* header;
+
+	header = self->header;
+
+	ekProfile_begin(ekOptimizer_profile(optim), ekProfilePhase_Evaluate);
+
+	count = ekDoorbell_count(&(header->tellBell));
+
+	ekDoorbell_lock(&(header->askBell));
+	header->lambda = ekOptimizer_lambda(optim);
+	header->generation += 1;
+	ekDoorbell_unlock(&(header->askBell));
+	ekDoorbell_ring(&(header->askBell));
+
+	while(1) {
+		ekDoorbell_lock(&(header->tellBell));
+		done = (header->fitnessGeneration == header->generation);
+		ekDoorbell_unlock(&(header->tellBell));
+
+		if (done)
+			break;
+
+		current = ekDoorbell_wait(&(header->tellBell), count, timeout);
+		if (current == count) {
+			ekProfile_end(ekOptimizer_profile(optim), ekProfilePhase_Evaluate);
+			return 0;
+		}
+		count = current;
+	}
+
+	ekOptimizer_setFitnesses(optim, self->fitnesses);
+
+	ekProfile_end(ekOptimizer_profile(optim), ekProfilePhase_Evaluate);
+
+	return 1;
+}
+
+
+
+size_t
+ekSharedChannel_ask(ekSharedChannel* self, double timeout) {
+	int closed;
+	uint32_t count, current;
+	uint64_t generation;
+	size_t lambda;
+	ekSharedChannelHeader* header;
+
+	header = self->header;
+
+	count = ekDoorbell_count(&(header->askBell));
+	while(1) {
+		ekDoorbell_lock(&(header->askBell));
+		closed = header->closed;
+		generation = header->generation;
+		lambda = header->lambda;
+		ekDoorbell_unlock(&(header->askBell));
+
+		if (closed)
+			return 0;
+
+		if (generation != self->generation) {
+			self->generation = generation;
+			return lambda;
+		}
+
+		current = ekDoorbell_wait(&(header->askBell), count, timeout);
+		if (current == count)
+			return 0;
+		count = current;
+	}
+}
+
+
+
+void
+ekSharedChannel_tell(ekSharedChannel* self) {
+	ekDoorbell_lock(&(self->header->tellBell));
+	self->header->fitnessGeneration = self->generation;
+	ekDoorbell_unlock(&(self->header->tellBell));
+
+	ekDoorbell_ring(&(self->header->tellBell));
+}
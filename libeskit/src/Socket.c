@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "eskit/Socket.h"
+
+
+
+/* --- Buffers ------------------------------------------------------------- */
+
+void
+ekSocketBuffer_init(ekSocketBuffer* self) {
+	self->data = NULL;
+	self->begin = 0;
+	self->end = 0;
+	self->capacity = 0;
+}
+
+
+
+void
+ekSocketBuffer_destroy(ekSocketBuffer* self) {
+	free(self->data);
+}
+
+
+
+unsigned char*
+ekSocketBuffer_reserve(ekSocketBuffer* self, size_t size) {
+	if (self->begin > 0) {
+		memmove(self->data, self->data + self->begin, self->end - self->begin);
+		self->end -= self->begin;
+		self->begin = 0;
+	}
+
+	if (self->end + size > self->capacity) {
+		self->capacity = 2 * (self->end + size);
+		self->data = (unsigned char*)realloc(self->data, self->capacity);
+	}
+
+	return self->data + self->end;
+}
+
+
+
+/* --- Encoding ------------------------------------------------------------ */
+
+void
+ekSocket_putU32(unsigned char* p, uint32_t value) {
+	p[0] = (unsigned char)(value);
+	p[1] = (unsigned char)(value >> 8);
+	p[2] = (unsigned char)(value >> 16);
+	p[3] = (unsigned char)(value >> 24);
+}
+
+
+
+uint32_t
+ekSocket_getU32(const unsigned char* p) {
+	return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+
+void
+ekSocket_putF64(unsigned char* p, double value) {
+	uint64_t bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	ekSocket_putU32(p, (uint32_t)bits);
+	ekSocket_putU32(p + 4, (uint32_t)(bits >> 32));
+}
+
+
+
+double
+ekSocket_getF64(const unsigned char* p) {
+	uint64_t bits;
+	double ret;
+
+	bits = ((uint64_t)ekSocket_getU32(p + 4) << 32) | ekSocket_getU32(p);
+	memcpy(&ret, &bits, sizeof(ret));
+	return ret;
+}
+
+
+
+void
+ekSocket_putHeader(unsigned char* p, uint32_t type, uint32_t a, uint32_t b, uint32_t c) {
+	ekSocket_putU32(p, type);
+	ekSocket_putU32(p + 4, a);
+	ekSocket_putU32(p + 8, b);
+	ekSocket_putU32(p + 12, c);
+}
+
+
+
+/* --- Connections --------------------------------------------------------- */
+
+static int
+ekSocket_resolve(const char* address, int passive, struct sockaddr_storage* addr, socklen_t* addrSize) {
+	int ret;
+	char* host;
+	const char* port;
+	struct sockaddr_un* unixAddr;
+	struct addrinfo hints, *info;
+
+	memset(addr, 0, sizeof(*addr));
+
+	if (strncmp(address, "unix:", 5) == 0) {
+		unixAddr = (struct sockaddr_un*)addr;
+		if (strlen(address + 5) >= sizeof(unixAddr->sun_path))
+			return 0;
+
+		unixAddr->sun_family = AF_UNIX;
+		strcpy(unixAddr->sun_path, address + 5);
+		*addrSize = sizeof(struct sockaddr_un);
+		return 1;
+	}
+
+	port = strrchr(address, ':');
+	if (port == NULL)
+		return 0;
+
+	host = strdup(address);
+	host[port - address] = '\0';
+	port += 1;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+	ret = getaddrinfo(((host[0] == '\0') || (strcmp(host, "*") == 0)) ? NULL : host, port, &hints, &info);
+	free(host);
+	if (ret != 0)
+		return 0;
+
+	memcpy(addr, info->ai_addr, info->ai_addrlen);
+	*addrSize = info->ai_addrlen;
+	freeaddrinfo(info);
+
+	return 1;
+}
+
+
+
+/* Small messages go out at once, the latency matters more than the throughput */
+static void
+ekSocket_setNoDelay(int fd, const struct sockaddr_storage* addr) {
+	int one = 1;
+
+	if (addr->ss_family != AF_UNIX)
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+
+
+int
+ekSocket_listen(const char* address, char** unixPath) {
+	int fd, one = 1;
+	struct sockaddr_storage addr;
+	socklen_t addrSize;
+
+	*unixPath = NULL;
+
+	if (!ekSocket_resolve(address, 1, &addr, &addrSize))
+		return -1;
+
+	fd = socket(addr.ss_family, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+
+	if (addr.ss_family == AF_UNIX) {
+		/* A stale socket file would prevent the bind */
+		*unixPath = strdup(((struct sockaddr_un*)&addr)->sun_path);
+		unlink(*unixPath);
+	}
+	else
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	if ((bind(fd, (struct sockaddr*)&addr, addrSize) != 0) || (listen(fd, SOMAXCONN) != 0)) {
+		close(fd);
+		free(*unixPath);
+		*unixPath = NULL;
+		return -1;
+	}
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+
+	return fd;
+}
+
+
+
+int
+ekSocket_accept(int listenFd) {
+	int fd;
+	struct sockaddr_storage addr;
+	socklen_t addrSize;
+
+	addrSize = sizeof(addr);
+	fd = accept(listenFd, (struct sockaddr*)&addr, &addrSize);
+	if (fd < 0)
+		return -1;
+
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	ekSocket_setNoDelay(fd, &addr);
+
+	return fd;
+}
+
+
+
+int
+ekSocket_connect(const char* address) {
+	int fd;
+	struct sockaddr_storage addr;
+	socklen_t addrSize;
+
+	if (!ekSocket_resolve(address, 0, &addr, &addrSize))
+		return -1;
+
+	fd = socket(addr.ss_family, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+
+	if (connect(fd, (struct sockaddr*)&addr, addrSize) != 0) {
+		close(fd);
+		return -1;
+	}
+	ekSocket_setNoDelay(fd, &addr);
+
+	return fd;
+}
+
+
+
+/* --- Transfers ----------------------------------------------------------- */
+
+int
+ekSocket_sendAll(int fd, const unsigned char* data, size_t size) {
+	ssize_t ret;
+
+	while(size > 0) {
+		ret = send(fd, data, size, MSG_NOSIGNAL);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return 0;
+		}
+		data += ret;
+		size -= ret;
+	}
+
+	return 1;
+}
+
+
+
+int
+ekSocket_recvAll(int fd, unsigned char* data, size_t size) {
+	ssize_t ret;
+
+	while(size > 0) {
+		ret = recv(fd, data, size, 0);
+		if (ret == 0)
+			return 0;
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return 0;
+		}
+		data += ret;
+		size -= ret;
+	}
+
+	return 1;
+}
+
+
+
+int
+ekSocket_flush(int fd, ekSocketBuffer* buffer) {
+	ssize_t ret;
+
+	while(buffer->begin < buffer->end) {
+		ret = send(fd, buffer->data + buffer->begin, buffer->end - buffer->begin, MSG_NOSIGNAL);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+		}
+		buffer->begin += ret;
+	}
+
+	return 1;
+}
+
+
+
+int
+ekSocket_read(int fd, ekSocketBuffer* buffer) {
+	ssize_t ret;
+	unsigned char* p;
+
+	while(1) {
+		p = ekSocketBuffer_reserve(buffer, 1 << 16);
+		ret = recv(fd, p, 1 << 16, 0);
+		if (ret == 0)
+			return 0;
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+		}
+		buffer->end += ret;
+	}
+}
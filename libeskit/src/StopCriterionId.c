@@ -19,7 +19,9 @@ ekStopCriterionStringArray[] =
 	"NoEffectCoord",
 	"ConditionCov",
 	"EigenSolverFailure",
-	"BestFitnessStall"
+	"BestFitnessStall",
+	"EvaluationBudget",
+	"Deadline"
 };
 
 
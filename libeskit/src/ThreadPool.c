@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <stdlib.h>
+#include "eskit/Macros.h"
+#include "eskit/ThreadPool.h"
+
+
+
+struct s_ekThreadPoolWorker {
+	ekThreadPool* pool;
+	size_t id;
+	pthread_t thread;
+
+	pthread_mutex_t rangeMutex;  /* Guards the items left to a range job    */
+	size_t begin;
+	size_t end;
+};
+
+
+
+/* Number of pool tasks being run by the current thread */
+static __thread int ekThreadPool_localDepth = 0;
+
+
+
+typedef struct {
+	ekThreadPool* pool;
+	ekThreadPoolRangeTask task;
+	void* data;
+	size_t chunkSize;
+} ekThreadPoolRangeJob;
+
+
+
+/* Claims and runs tasks of the current job, called with the mutex held */
+static void
+ekThreadPool_work(ekThreadPool* self, size_t workerId) {
+	size_t taskId;
+
+	while(self->nextTask < self->nbTasks) {
+		taskId = self->nextTask;
+		self->nextTask += 1;
+
+		pthread_mutex_unlock(&(self->mutex));
+		ekThreadPool_localDepth += 1;
+		self->task(self->data, taskId, workerId);
+		ekThreadPool_localDepth -= 1;
+		pthread_mutex_lock(&(self->mutex));
+
+		self->nbTasksDone += 1;
+		if (self->nbTasksDone == self->nbTasks)
+			pthread_cond_broadcast(&(self->doneCond));
+	}
+}
+
+
+
+static void*
+ekThreadPool_main(void* arg) {
+	size_t lastJobId;
+	ekThreadPool* self;
+	struct s_ekThreadPoolWorker* worker;
+
+	worker = (struct s_ekThreadPoolWorker*)arg;
+	self = worker->pool;
+
+	pthread_mutex_lock(&(self->mutex));
+	lastJobId = self->jobId;
+	while(1) {
+		while((!self->shutdown) && (self->jobId == lastJobId))
+			pthread_cond_wait(&(self->jobCond), &(self->mutex));
+
+		if (self->shutdown)
+			break;
+
+		lastJobId = self->jobId;
+		ekThreadPool_work(self, worker->id);
+	}
+	pthread_mutex_unlock(&(self->mutex));
+
+	return NULL;
+}
+
+
+
+void
+ekThreadPool_init(ekThreadPool* self, size_t nbThreads) {
+	size_t i;
+
+	if (nbThreads == 0)
+		nbThreads = 1;
+
+	self->nbThreads = nbThreads;
+	self->task = NULL;
+	self->data = NULL;
+	self->nbTasks = 0;
+	self->nextTask = 0;
+	self->nbTasksDone = 0;
+	self->jobId = 0;
+	self->shutdown = 0;
+
+	pthread_mutex_init(&(self->mutex), NULL);
+	pthread_cond_init(&(self->jobCond), NULL);
+	pthread_cond_init(&(self->doneCond), NULL);
+
+	/* Worker 0 is the calling thread, no need to spawn it */
+	self->workers = newArray(struct s_ekThreadPoolWorker, nbThreads);
+	for(i = 0; i < nbThreads; ++i) {
+		self->workers[i].pool = self;
+		self->workers[i].id = i;
+		pthread_mutex_init(&(self->workers[i].rangeMutex), NULL);
+	}
+
+	for(i = 1; i < nbThreads; ++i)
+		pthread_create(&(self->workers[i].thread), NULL, ekThreadPool_main, self->workers + i);
+}
+
+
+
+void
+ekThreadPool_destroy(ekThreadPool* self) {
+	size_t i;
+
+	pthread_mutex_lock(&(self->mutex));
+	self->shutdown = 1;
+	pthread_cond_broadcast(&(self->jobCond));
+	pthread_mutex_unlock(&(self->mutex));
+
+	for(i = 1; i < self->nbThreads; ++i)
+		pthread_join(self->workers[i].thread, NULL);
+
+	for(i = 0; i < self->nbThreads; ++i)
+		pthread_mutex_destroy(&(self->workers[i].rangeMutex));
+
+	free(self->workers);
+	pthread_cond_destroy(&(self->doneCond));
+	pthread_cond_destroy(&(self->jobCond));
+	pthread_mutex_destroy(&(self->mutex));
+}
+
+
+
+void
+ekThreadPool_run(ekThreadPool* self, ekThreadPoolTask task, void* data, size_t nbTasks) {
+	if (nbTasks == 0)
+		return;
+
+	pthread_mutex_lock(&(self->mutex));
+
+	/* Submit the job */
+	self->task = task;
+	self->data = data;
+	self->nbTasks = nbTasks;
+	self->nextTask = 0;
+	self->nbTasksDone = 0;
+	self->jobId += 1;
+	pthread_cond_broadcast(&(self->jobCond));
+
+	/* The caller works as well, then waits for the stragglers */
+	ekThreadPool_work(self, 0);
+	while(self->nbTasksDone < self->nbTasks)
+		pthread_cond_wait(&(self->doneCond), &(self->mutex));
+
+	pthread_mutex_unlock(&(self->mutex));
+}
+
+
+
+/* Takes a chunk from the front of the items left to a worker, returns 0 if none */
+static int
+ekThreadPool_popChunk(struct s_ekThreadPoolWorker* worker, size_t chunkSize, size_t* begin, size_t* end) {
+	int ret;
+
+	pthread_mutex_lock(&(worker->rangeMutex));
+	ret = worker->begin < worker->end;
+	if (ret) {
+		*begin = worker->begin;
+		*end = (worker->end - worker->begin > chunkSize) ? worker->begin + chunkSize : worker->end;
+		worker->begin = *end;
+	}
+	pthread_mutex_unlock(&(worker->rangeMutex));
+
+	return ret;
+}
+
+
+
+/* Moves half of the items left to another worker to a thief, returns 0 if none */
+static int
+ekThreadPool_steal(ekThreadPool* self, struct s_ekThreadPoolWorker* thief) {
+	size_t i, begin, end;
+	struct s_ekThreadPoolWorker* victim;
+
+	for(i = 1; i < self->nbThreads; ++i) {
+		victim = self->workers + (thief->id + i) % self->nbThreads;
+
+		/* Only one lock held at a time, the back half of the victim items is taken */
+		pthread_mutex_lock(&(victim->rangeMutex));
+		end = victim->end;
+		begin = end - (end - victim->begin) / 2;
+		if ((begin == end) && (victim->begin < end))
+			begin -= 1;
+		victim->end = begin;
+		pthread_mutex_unlock(&(victim->rangeMutex));
+
+		if (begin < end) {
+			pthread_mutex_lock(&(thief->rangeMutex));
+			thief->begin = begin;
+			thief->end = end;
+			pthread_mutex_unlock(&(thief->rangeMutex));
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+
+static void
+ekThreadPool_rangeWorker(void* data, size_t ESKIT_UNUSED(taskId), size_t workerId) {
+	size_t begin, end;
+	ekThreadPoolRangeJob* job;
+	struct s_ekThreadPoolWorker* worker;
+
+	job = (ekThreadPoolRangeJob*)data;
+	worker = job->pool->workers + workerId;
+
+	/* The ranges only shrink, no work is left once a steal fails */
+	do {
+		while(ekThreadPool_popChunk(worker, job->chunkSize, &begin, &end))
+			job->task(job->data, begin, end, workerId);
+	} while(ekThreadPool_steal(job->pool, worker));
+}
+
+
+
+void
+ekThreadPool_runRange(ekThreadPool* self, ekThreadPoolRangeTask task, void* data, size_t nbItems, size_t chunkSize) {
+	size_t i;
+	ekThreadPoolRangeJob job;
+
+	if (nbItems == 0)
+		return;
+
+	if (chunkSize == 0)
+		chunkSize = 1;
+
+	if (self->nbThreads == 1) {
+		ekThreadPool_localDepth += 1;
+		for(i = 0; i < nbItems; i += chunkSize)
+			task(data, i, (nbItems - i > chunkSize) ? i + chunkSize : nbItems, 0);
+		ekThreadPool_localDepth -= 1;
+		return;
+	}
+
+	/* Equal shares to start with */
+	for(i = 0; i < self->nbThreads; ++i) {
+		self->workers[i].begin = (i * nbItems) / self->nbThreads;
+		self->workers[i].end = ((i + 1) * nbItems) / self->nbThreads;
+	}
+
+	job.pool = self;
+	job.task = task;
+	job.data = data;
+	job.chunkSize = chunkSize;
+
+	/* A worker which does not claim a task has its share stolen */
+	ekThreadPool_run(self, ekThreadPool_rangeWorker, &job, self->nbThreads);
+}
+
+
+
+int
+ekThreadPool_inTask(void) {
+	return ekThreadPool_localDepth > 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#include <stdlib.h>
+#include "eskit/Macros.h"
+#include "eskit/Clock.h"
+#include "eskit/Trace.h"
+
+
+
+/* Thread identifiers, given on the first event recorded by each thread */
+static uint32_t ekTrace_nbThreads = 0;
+
+static __thread int64_t ekTrace_localThreadId = -1;
+
+
+
+static uint32_t
+ekTrace_threadId(void) {
+	if (ekTrace_localThreadId < 0)
+		ekTrace_localThreadId = __atomic_fetch_add(&ekTrace_nbThreads, 1, __ATOMIC_RELAXED);
+
+	return (uint32_t)ekTrace_localThreadId;
+}
+
+
+
+void
+ekTrace_init(ekTrace* self, size_t capacity) {
+	self->capacity = capacity;
+	self->events = newArray(ekTraceEvent, capacity);
+
+	ekTrace_clear(self);
+}
+
+
+
+void
+ekTrace_destroy(ekTrace* self) {
+	free(self->events);
+}
+
+
+
+void
+ekTrace_clear(ekTrace* self) {
+	self->nbEventsRequested = 0;
+	self->origin = ekClock_now();
+}
+
+
+
+static void
+ekTrace_record(ekTrace* self, enum ekProfilePhase phase, int64_t arg, char type) {
+	size_t index;
+	ekTraceEvent* event;
+
+	/* Each event gets its own slot, no other synchronization needed */
+	index = __atomic_fetch_add(&(self->nbEventsRequested), 1, __ATOMIC_RELAXED);
+	if (index >= self->capacity)
+		return;
+
+	event = self->events + index;
+	event->time = ekClock_now() - self->origin;
+	event->arg = arg;
+	event->threadId = ekTrace_threadId();
+	event->phase = (uint16_t)phase;
+	event->type = type;
+}
+
+
+
+void
+ekTrace_begin(ekTrace* self, enum ekProfilePhase phase, int64_t arg) {
+	ekTrace_record(self, phase, arg, 'B');
+}
+
+
+
+void
+ekTrace_end(ekTrace* self, enum ekProfilePhase phase, int64_t arg) {
+	ekTrace_record(self, phase, arg, 'E');
+}
+
+
+
+int
+ekTrace_dump(const ekTrace* self, FILE* file) {
+	size_t i, nbEvents;
+	const ekTraceEvent* event;
+
+	nbEvents = ekTrace_nbEvents(self);
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	for(i = 0, event = self->events; i < nbEvents; ++i, ++event) {
+		fprintf(file, 
+		        "%s\n{\"name\":\"%s\",\"cat\":\"eskit\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+		        (i == 0) ? "" : ",",
+		        ekProfilePhaseString(event->phase),
+		        event->type,
+		        1e6 * event->time,
+		        event->threadId);
+
+		if (event->arg >= 0)
+			fprintf(file, ",\"args\":{\"index\":%lld}", (long long)event->arg);
+
+		fputc('}', file);
+	}
+	fprintf(file, "\n]}\n");
+
+	return (!ferror(file)) && (fflush(file) == 0);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the 
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <getopt.h>
+#include <eskit.h>
+
+
+
+/*
+   Optimization server : hosts the ask/tell sessions of the clients, until
+   interrupted. The sessions are stepped on a thread pool.
+ */
+
+static volatile sig_atomic_t stopped = 0;
+
+
+
+static void
+onSignal(int signal) {
+	(void)signal;
+	stopped = 1;
+}
+
+
+
+static struct option long_options[] = 
+{
+	{"threads",  1, NULL, 't'},
+	{"sessions", 1, NULL, 's'},
+	{"dim",      1, NULL, 'd'},
+	{"lambda",   1, NULL, 'l'},
+	{"help",     0, NULL, 'h'},
+	{NULL,       0, NULL, 0}
+};
+
+static char* option_string = "t:s:d:l:h";
+
+
+
+static const char* usage =
+"Usage: eskit-server [OPTION...] ADDRESS\n\n"
+"  -t, --threads=NUMBER   threads stepping the sessions\n"
+"  -s, --sessions=NUMBER  maximum number of sessions\n"
+"  -d, --dim=NUMBER       maximum dimension of a session\n"
+"  -l, --lambda=NUMBER    maximum population size of a session\n\n"
+"ADDRESS is either unix:PATH or HOST:PORT\n";
+
+
+
+int
+main(int argc, char* argv[]) {
+	int ret, optionIndex;
+	size_t nbThreads, maxSessions, maxN, maxLambda;
+	struct sigaction action;
+	ekThreadPool pool;
+	ekServer server;
+
+	nbThreads = 1;
+	maxSessions = 65536;
+	maxN = 1024;
+	maxLambda = 1024;
+
+	while((ret = getopt_long(argc, argv, option_string, long_options, &optionIndex)) != -1) {
+		switch(ret) {
+			case 't':
+			nbThreads = strtoul(optarg, NULL, 10);
+			break;
+
+			case 's':
+			maxSessions = strtoul(optarg, NULL, 10);
+			break;
+
+			case 'd':
+			maxN = strtoul(optarg, NULL, 10);
+			break;
+
+			case 'l':
+			maxLambda = strtoul(optarg, NULL, 10);
+			break;
+
+			default:
+			printf("%s", usage);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if ((optind != argc - 1) || (nbThreads == 0) || (maxSessions == 0) || (maxN == 0) || (maxLambda < 2)) {
+		printf("%s", usage);
+		return EXIT_FAILURE;
+	}
+
+	if (!ekServer_init(&server, argv[optind])) {
+		fprintf(stderr, "can't listen on '%s'\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+	ekServer_setLimits(&server, maxSessions, maxN, maxLambda);
+
+	ekThreadPool_init(&pool, nbThreads);
+	if (nbThreads > 1)
+		ekServer_setThreadPool(&server, &pool);
+
+	/* Interrupted system calls are not restarted, so that poll returns */
+	action.sa_handler = onSignal;
+	action.sa_flags = 0;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	while(!stopped)
+		ekServer_poll(&server, 1.0);
+
+	fprintf(stderr, "%zu steps in %zu batches, %zu sessions left\n", ekServer_nbSteps(&server), ekServer_nbBatches(&server), ekServer_nbSessions(&server));
+
+	ekServer_destroy(&server);
+	ekThreadPool_destroy(&pool);
+
+	return EXIT_SUCCESS;
+}
@@ -10,7 +10,7 @@
 
 #include <stdint.h>
 #include "Function.h"
-#include "Distribution.h"
+#include <eskit.h>
 
 
 
@@ -30,11 +30,25 @@ typedef struct {
 
 	size_t nbEvals;
 
+	size_t nbThreads;
+
+	int deterministic;
+
+	size_t timeLimit;
+
+	int profile;
+
+	const char* traceFileName;
+
+	const char* workersAddress;
+
+	int archive;
+
 	int randRot;
 
 	const Function* function;
 
-	const DistributionBuilder* distribBuilder;
+	const ekDistributionBuilder* distribBuilder;
 } Configuration;
 
 
@@ -19,13 +19,20 @@ void
 Configuration_init(Configuration* self) {
 	self->dim = 10;
 	self->nbEvals = 100000;
+	self->nbThreads = 1;
+	self->timeLimit = 0;
+	self->profile = 0;
+	self->traceFileName = NULL;
+	self->workersAddress = NULL;
+	self->deterministic = 0;
+	self->archive = 0;
 	self->nbRuns = 1;
 	self->generateSeed = 1;
 	self->setMu = 0;
 	self->setLambda = 0;
 	self->randRot = 0;
 	self->function = DefaultFunction;
-	self->distribBuilder = DefaultDistributionBuilder;
+	self->distribBuilder = &ekCMA_DistributionBuilder;
 }
 
 
@@ -41,11 +48,18 @@ static struct option long_options[] =
 	{"lambda",   1, NULL, 'l'},
 	{"update",   1, NULL, 'u'},
 	{"rotate",   0, NULL, 'r'},
+	{"threads",  1, NULL, 't'},
+	{"deterministic", 0, NULL, 'D'},
+	{"time",     1, NULL, 'T'},
+	{"profile",  0, NULL, 'P'},
+	{"trace",    1, NULL, 'x'},
+	{"workers",  1, NULL, 'w'},
+	{"archive",  0, NULL, 'A'},
 	{"help",     0, NULL, 'h'},
 	{NULL,       0, NULL, 0}
 };
 
-static char* option_string = "d:e:n:s:f:m:l:u:r";
+static char* option_string = "d:e:n:s:f:m:l:u:rt:DT:Px:w:A";
 
 
 
@@ -59,7 +73,15 @@ static const char* usage =
 "  -m, --mu=NUMBER        mu ES parameter\n"
 "  -l, --lambda=NUMBER    lambda ES parameter\n"
 "  -u, --update=NAME      point distribution update\n"
-"  -r, --rotate           apply random rotation to benchmark function\n";
+"  -r, --rotate           apply random rotation to benchmark function\n"
+"  -t, --threads=NUMBER   number of threads used to sample the points\n"
+"  -D, --deterministic    same results whatever the number of threads\n"
+"  -T, --time=SECONDS     time limit per run, 0 for none\n"
+"  -P, --profile          print the time spent in each phase of the runs\n"
+"  -x, --trace=FILE       write a Chrome trace of the runs to FILE\n"
+"  -w, --workers=ADDRESS  evaluate on eskit-worker processes connecting to\n"
+"                         ADDRESS, either unix:PATH or HOST:PORT\n"
+"  -A, --archive          archive all the evaluated points of each run\n";
 
 
 
@@ -183,7 +205,7 @@ Configuration_parseCmdLine(Configuration* self, int argc, char* argv[]) {
 
 			/* User distribution choice */
 			case 'u':
-			self->distribBuilder = getDistributionBuilderByName(optarg);
+			self->distribBuilder = ekDistributionBuilder_byName(optarg);
 			if (self->distribBuilder == NULL) {
 				fprintf(stderr, "update '%s' not defined\n", optarg);
 				return 0;
@@ -195,6 +217,49 @@ Configuration_parseCmdLine(Configuration* self, int argc, char* argv[]) {
 			self->randRot = 1;
 			break;
 
+			/* Number of sampling threads */
+			case 't':
+			if ((!str2uint32(optarg, &value)) || (value == 0)) {
+				fprintf(stderr, "Bogus number of threads setting\n");
+				return 0;
+			}
+			self->nbThreads = value;
+			break;
+
+			/* Time limit per run */
+			case 'T':
+			if (!str2uint32(optarg, &value)) {
+				fprintf(stderr, "Bogus time limit setting\n");
+				return 0;
+			}
+			self->timeLimit = value;
+			break;
+
+			/* Print the phases timing */
+			case 'P':
+			self->profile = 1;
+			break;
+
+			/* Trace file */
+			case 'x':
+			self->traceFileName = optarg;
+			break;
+
+			/* Remote workers */
+			case 'w':
+			self->workersAddress = optarg;
+			break;
+
+			/* Sampling independent from the threads */
+			case 'D':
+			self->deterministic = 1;
+			break;
+
+			/* Archive of the evaluated points */
+			case 'A':
+			self->archive = 1;
+			break;
+
 			/* LOL, WTF happened */
 			default:
 				return 0;
@@ -254,6 +319,12 @@ Configuration_setup(Configuration* self) {
 		fprintf(stderr, "'lambda' inferior to 'mu'\n");
 		return 0;
 	}
+
+	/* The workers evaluate the function as is */
+	if ((self->workersAddress != NULL) && (self->randRot)) {
+		fprintf(stderr, "Remote workers can't evaluate a rotated function\n");
+		return 0;
+	}
 	
 	/* Job done */
 	return 1;
@@ -5,24 +5,44 @@
  * terms of the MIT license. See LICENSE for details.
  */
 
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <eskit.h>
+#include <eskit/Macros.h>
 #include "Evaluator.h"
 #include "Configuration.h"
 
 
 
+/* Batches sent to the remote workers */
+#define workerBatchSize 4
+#define workerBatchDepth 2
+
+
+
+/* Logs the best fitness after each generation */
+static void
+logGeneration(void* data, const ekOptimizer* ESKIT_UNUSED(optim), const ekGenerationView* view) {
+	fprintf((FILE*)data, "%zu %e\n", view->nbEvaluations, view->bestFitness);
+}
+
+
+
 int
 main(int argc, char* argv[]) {
 	uint32_t runSeed, evalSeed;
 	ekRandomizer randomizer;
-	size_t i, nbEvals, nbRuns;
+	size_t i, nbRuns;
 	ekOptimizer optim;
 	Evaluator evaluator;
 	Configuration config;
 	ekDistribution distrib;
+	ekThreadPool threadPool;
+	ekTrace trace;
+	ekCoordinator coordinator;
+	ekArchive archive;
 
 	char logFileName[256];
 	FILE* logFile;
@@ -52,6 +72,24 @@ main(int argc, char* argv[]) {
 	ekDistribution_initFromBuilder(&distrib, config.distribBuilder, config.dim, evaluator.sigmaInit, 10e-12);
 	ekOptimizer_setDistribution(&optim, &distrib);
 
+	if (config.nbThreads > 1) {
+		ekThreadPool_init(&threadPool, config.nbThreads);
+		ekOptimizer_setThreadPool(&optim, &threadPool);
+	}
+	ekOptimizer_setDeterministic(&optim, config.deterministic);
+
+	if (config.workersAddress != NULL) {
+		if (!ekCoordinator_init(&coordinator, config.workersAddress, config.dim, workerBatchSize, workerBatchDepth)) {
+			fprintf(stderr, "Can't listen on '%s'\n", config.workersAddress);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (config.traceFileName != NULL) {
+		ekTrace_init(&trace, 1 << 20);
+		ekOptimizer_setTrace(&optim, &trace);
+	}
+
 	/* Perform each run */
 	for(nbRuns = 0; nbRuns < config.nbRuns; ++nbRuns) {
 		/* Open the log file */
@@ -61,12 +99,26 @@ main(int argc, char* argv[]) {
 			strcpy(logFileName, "run.dat");
 
 		logFile =	fopen(logFileName, "w");
+		ekOptimizer_addObserver(&optim, logGeneration, logFile);
+
+		/* Open the archive, next to the log file */
+		if (config.archive) {
+			strcpy(logFileName + strlen(logFileName) - 3, "arc");
+			if (!ekArchive_create(&archive, logFileName, config.dim, 0)) {
+				fprintf(stderr, "Can't create '%s'\n", logFileName);
+				return EXIT_FAILURE;
+			}
+			ekOptimizer_addObserver(&optim, ekArchive_observe, &archive);
+		}
 
 		/* Run */
 		runSeed = ekRandomizer_next(&randomizer);
 		ekArrayOpsD_copy(ekOptimizer_xMean(&optim), evaluator.xMeanInit, ekOptimizer_N(&optim));
 
 		ekRandomizer_seed(ekOptimizer_getRandomizer(&optim), runSeed);
+		ekOptimizer_setEvaluationBudget(&optim, config.nbEvals);
+		if (config.timeLimit > 0)
+			ekOptimizer_setDeadline(&optim, config.timeLimit);
 		ekOptimizer_start(&optim);
 
 		fprintf(logFile, "# evaluator : seed = %u function = '%s' N = %zu rotated = %d\n", 
@@ -80,31 +132,47 @@ main(int argc, char* argv[]) {
   	        runSeed, 
   	        distrib.delegate.name);
 
-		nbEvals = 0;
 		do {
 			ekOptimizer_sampleCloud(&optim);
 		
-			for(i = 0; i < ekOptimizer_lambda(&optim); ++i)
-				ekOptimizer_point(&optim, i).fitness = Evaluator_evaluate(&evaluator, ekOptimizer_point(&optim, i).x);
-			nbEvals += ekOptimizer_lambda(&optim);
+			if (config.workersAddress != NULL)
+				ekCoordinator_evaluate(&coordinator, &optim, HUGE_VAL);
+			else {
+				ekProfile_begin(ekOptimizer_profile(&optim), ekProfilePhase_Evaluate);
+				for(i = 0; i < ekOptimizer_lambda(&optim); ++i)
+					ekOptimizer_point(&optim, i).fitness = Evaluator_evaluate(&evaluator, ekOptimizer_point(&optim, i).x);
+				ekProfile_end(ekOptimizer_profile(&optim), ekProfilePhase_Evaluate);
+			}
 
 			ekOptimizer_update(&optim);
-
-			/* Log best fitness */
-			fprintf(logFile, "%zu %e\n",
-              nbEvals, 
-						  ekOptimizer_bestPoint(&optim).fitness);
-			/*
-			fprintf(logFile, "%zu %e %e\n", 
-              nbEvals, 
-						  ekOptimizer_bestPoint(&optim).fitness, 
-              distrib.sigma);
-	    */
-			fflush(logFile);
-		} while((ekOptimizer_stop(&optim) == 0) && (nbEvals < config.nbEvals) && (ekOptimizer_bestPoint(&optim).fitness > 10e-10));
+		} while((ekOptimizer_stop(&optim) == 0) && (ekOptimizer_bestPoint(&optim).fitness > 10e-10));
 
 		/* Close the log file */
+		ekOptimizer_removeObserver(&optim, logGeneration, logFile);
 		fclose(logFile);
+
+		if (config.archive) {
+			ekOptimizer_removeObserver(&optim, ekArchive_observe, &archive);
+			ekArchive_close(&archive);
+		}
+	}
+
+	/* Time spent in each phase, for all the runs */
+	if (config.profile)
+		for(i = 0; i < ekProfilePhase_Count; ++i)
+			printf("%-20s %10zu calls %12.6f s\n", 
+			       ekProfilePhaseString(i), 
+			       ekOptimizer_profile(&optim)->nbCalls[i], 
+			       ekOptimizer_profile(&optim)->time[i]);
+
+	/* Write the trace of all the runs */
+	if (config.traceFileName != NULL) {
+		logFile = fopen(config.traceFileName, "w");
+		if (logFile != NULL) {
+			ekTrace_dump(&trace, logFile);
+			fclose(logFile);
+		}
+		ekTrace_destroy(&trace);
 	}
 
 	/* Job done */
@@ -113,5 +181,11 @@ main(int argc, char* argv[]) {
 	ekDistribution_destroy(&distrib, config.distribBuilder);
 	ekRandomizer_destroy(&randomizer);
 
+	if (config.nbThreads > 1)
+		ekThreadPool_destroy(&threadPool);
+
+	if (config.workersAddress != NULL)
+		ekCoordinator_destroy(&coordinator);
+
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2009-2023 Alexandre Devert <marmakoide@hotmail.fr>
+ *
+ * ESKit is free software; you can redistribute it and/or modify it under the 
+ * terms of the MIT license. See LICENSE for details.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <eskit.h>
+#include "Function.h"
+
+
+
+/*
+   Reference worker for ekCoordinator : evaluates a benchmark function for
+   a coordinator, optionally slowed down or dying after a number of
+   evaluations, to load test the coordinator on a single machine.
+ */
+
+static const Function* function;
+
+static struct timespec cost;
+
+static unsigned long nbEvaluationsLeft;
+
+
+
+static double
+evaluate(const double* x, size_t N) {
+	if ((cost.tv_sec > 0) || (cost.tv_nsec > 0))
+		nanosleep(&cost, NULL);
+
+	/* Simulates a crash, the coordinator sending the batch to another worker */
+	if (nbEvaluationsLeft > 0) {
+		nbEvaluationsLeft -= 1;
+		if (nbEvaluationsLeft == 0)
+			_exit(EXIT_FAILURE);
+	}
+
+	return function->compute(x, N);
+}
+
+
+
+static struct option long_options[] = 
+{
+	{"function", 1, NULL, 'f'},
+	{"cost",     1, NULL, 'c'},
+	{"crash",    1, NULL, 'k'},
+	{"help",     0, NULL, 'h'},
+	{NULL,       0, NULL, 0}
+};
+
+static char* option_string = "f:c:k:h";
+
+
+
+static const char* usage =
+"Usage: eskit-worker [OPTION...] ADDRESS\n\n"
+"  -f, --function=NAME    benchmark function\n"
+"  -c, --cost=MICROSEC    time spent on each evaluation\n"
+"  -k, --crash=NUMBER     exit abruptly at the given evaluation\n\n"
+"ADDRESS is either unix:PATH or HOST:PORT\n";
+
+
+
+int
+main(int argc, char* argv[]) {
+	int ret, optionIndex;
+	long micros;
+
+	function = DefaultFunction;
+	micros = 0;
+	nbEvaluationsLeft = 0;
+
+	while((ret = getopt_long(argc, argv, option_string, long_options, &optionIndex)) != -1) {
+		switch(ret) {
+			case 'f':
+			function = getFunctionByName(optarg);
+			if (function == NULL) {
+				fprintf(stderr, "function '%s' not defined\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+
+			case 'c':
+			micros = atol(optarg);
+			break;
+
+			case 'k':
+			nbEvaluationsLeft = strtoul(optarg, NULL, 10);
+			break;
+
+			default:
+			printf("%s", usage);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		printf("%s", usage);
+		return EXIT_FAILURE;
+	}
+
+	cost.tv_sec = micros / 1000000;
+	cost.tv_nsec = (micros % 1000000) * 1000;
+
+	if (!ekCoordinator_runWorker(argv[optind], evaluate)) {
+		fprintf(stderr, "connection to '%s' failed or lost\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}